@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+enum class BatchMode { Copy, Move };
+enum class ConflictPolicy { Overwrite, Skip };
+
+struct BatchOptions {
+    ConflictPolicy conflicts = ConflictPolicy::Overwrite;
+    // Hash while copying, re-read each copy from disk and compare, then
+    // record the digests in the destination's checksum manifest
+    bool verify = false;
+};
+
+struct BatchItem {
+    enum Kind { Directory, File, Symlink, Rename };
+
+    Kind kind;
+    std::string source;
+    std::string destination;
+    std::uint64_t size = 0;
+    dev_t device = 0;
+    ino_t inode = 0;
+    std::uint64_t physical = 0; // first extent from FIEMAP, 0 when unknown
+    bool conflict = false;      // destination already exists
+};
+
+// Everything a paste will do, worked out before the first byte moves
+struct BatchPlan {
+    BatchMode mode = BatchMode::Copy;
+    std::string destination;
+    // Directories first (pre-order), then files ordered by device and
+    // on-disk position so the source is read as sequentially as possible
+    std::vector<BatchItem> items;
+    // Cross-device moves: sources removed once everything was copied
+    std::vector<std::string> removeAfter;
+    std::uint64_t totalBytes = 0;
+    std::size_t totalFiles = 0;
+    std::size_t conflicts = 0;
+    std::vector<std::string> errors;
+};
+
+struct BatchProgress {
+    std::uint64_t bytesDone = 0;
+    std::uint64_t bytesTotal = 0;
+    std::size_t filesDone = 0;
+    std::size_t filesTotal = 0;
+    std::string current;
+};
+
+struct BatchResult {
+    bool cancelled = false;
+    std::size_t verified = 0;
+    std::vector<std::string> failures;
+};
+
+// Plans and executes multi-source copy/move as a single job
+class BatchOperation {
+public:
+    using ProgressCallback = std::function<void(const BatchProgress &)>;
+    using CancelCheck = std::function<bool()>;
+
+    static BatchPlan plan(const std::vector<std::string> &sources, const std::string &destDir, BatchMode mode);
+    static BatchResult run(const BatchPlan &plan, const BatchOptions &options,
+                           const ProgressCallback &progress, const CancelCheck &cancelled);
+
+    // Copies the remaining contents of in to out, preferring copy_file_range
+    // (reflinks, server-side copies) and falling back to read/write
+    static bool copyData(int in, int out, const std::function<void(std::uint64_t)> &advance, const CancelCheck &cancelled);
+    static int openSource(const std::string &path);
+};
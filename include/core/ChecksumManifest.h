@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+class HashPipeline;
+
+struct ManifestEntry {
+    std::string digest; // hex SHA-256
+    std::uint64_t size = 0;
+    std::int64_t mtimeNs = 0;
+};
+
+struct VerifyReport {
+    std::size_t verified = 0;
+    std::vector<std::string> corrupt; // same size and mtime, different content
+    std::vector<std::string> changed; // legitimately modified, re-hashed
+    std::vector<std::string> missing;
+    std::vector<std::string> unreadable; // tracked, but could not be read back
+    std::vector<std::string> added; // only with addNew
+    bool cancelled = false;
+};
+
+// Per-directory checksum list written by verified copies, one line per file:
+//   <sha256>  <size> <mtime-ns> <relative path>
+// A later verify() only reads the files the manifest tracks and keeps it
+// current: modified files are re-hashed, vanished ones dropped. Untracked
+// files are hashed and recorded only when asked to (addNew).
+class ChecksumManifest {
+public:
+    static constexpr const char *kFileName = ".raefile-manifest.sha256";
+
+    static std::string pathFor(const std::string &dir) { return dir + "/" + kFileName; }
+
+    bool load(const std::string &path);
+    bool save(const std::string &path) const;
+
+    const ManifestEntry *find(const std::string &relPath) const;
+    void set(const std::string &relPath, ManifestEntry entry) { m_entries[relPath] = std::move(entry); }
+
+    static VerifyReport verify(const std::string &dir, HashPipeline &pipeline, bool addNew,
+                               const std::function<bool()> &cancelled);
+    // The manifest itself and its in-progress save, at any depth
+    static bool isManifestFile(const std::string &name);
+
+private:
+    std::map<std::string, ManifestEntry> m_entries;
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "core/SearchScope.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+// Depth-first walk over the roots of a SearchScope using open/readdir. Each
+// directory is opened with O_NOFOLLOW and checked against the (device, inode)
+// it was admitted with. Entries are handed out per directory (in chunks),
+// together with an open descriptor of that directory for callers that want
+// fstatat().
+class DirectoryWalker {
+public:
+    struct Entry {
+        std::string name;
+        bool isDir;
+    };
+
+    using Visitor = std::function<void(const std::string &dirPath, int dirFd, const std::vector<Entry> &entries)>;
+    using CancelCheck = std::function<bool()>;
+
+    static constexpr std::size_t kChunkSize = 4096;
+
+    explicit DirectoryWalker(const SearchScope &scope) : m_scope(scope) {}
+
+    void walk(const Visitor &visit, const CancelCheck &cancelled) const;
+
+private:
+    const SearchScope &m_scope;
+};
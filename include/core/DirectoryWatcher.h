@@ -0,0 +1,47 @@
+#pragma once
+
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+class QSocketNotifier;
+class QTimer;
+
+// Watches one directory with inotify and reports which entries changed,
+// coalesced over a short window. Busy directories (logs, spools) widen the
+// window up to a cap instead of flooding the view; when the kernel queue or
+// the pending set overflows, a single overflowed() asks for a full relist.
+class DirectoryWatcher : public QObject {
+    Q_OBJECT
+public:
+    explicit DirectoryWatcher(QObject *parent = nullptr);
+    ~DirectoryWatcher() override;
+
+    // Re-watching the same path (a relist after overflow) keeps the current
+    // window, so a storm stays backed off
+    bool watch(const QString &path);
+    void stop();
+
+    static constexpr int kMinWindowMs = 50;
+    static constexpr int kMaxWindowMs = 1000;
+    static constexpr int kMaxPending = 4096;
+
+signals:
+    // Names (relative to the watched directory) created, removed or modified
+    void changed(const QStringList &names);
+    void overflowed();
+
+private:
+    void readEvents();
+    void flush();
+
+    QString m_path;
+    int m_fd = -1;
+    int m_wd = -1;
+    QSocketNotifier *m_notifier = nullptr;
+    QTimer *m_window;
+    int m_windowMs = kMinWindowMs;
+    QSet<QString> m_pending;
+    bool m_overflow = false;
+};
@@ -5,7 +5,18 @@
 #include <QDateTime>
 #include <QObject>
 #include <filesystem>
-#include <future>
+#include <functional>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <QStringList>
+#include "core/BatchOperation.h"
+#include "core/ChecksumManifest.h"
+#include "core/SearchQuery.h"
+#include "core/SearchResultStore.h"
+#include "core/SearchScope.h"
+#include "core/SearchSession.h"
+#include "core/SyncOperation.h"
 
 namespace fs = std::filesystem;
 
@@ -25,15 +36,51 @@ class FileSystemEngine : public QObject {
     Q_OBJECT
 public:
     explicit FileSystemEngine(QObject *parent = nullptr);
+    ~FileSystemEngine() override;
     
-    // Async directory listing
-    std::future<QVector<FileInfo>> listDirectory(const QString &path);
+    // Async directory listing; the callback runs on a pool thread
+    using ListingCallback = std::function<void(QVector<FileInfo>)>;
+    void listDirectoryAsync(const QString &path, ListingCallback callback);
+    // Blocking variants, for callers already off the UI thread and for
+    // refreshing single entries
+    static QVector<FileInfo> readDirectory(const QString &path);
+    static bool statEntry(const QString &dirPath, const QString &name, FileInfo *info);
 
     // Global Search
-    using SearchCallback = std::function<void(const FileInfo&)>;
-    void searchAsync(const QString &query, SearchCallback callback);
+    // Hits are appended to store; callback is throttled and tells the caller
+    // to pull new rows (finished = the walk completed). Callers drop anything
+    // for which isCurrentSearch() no longer holds.
+    using SearchGeneration = SearchSession::Generation;
+    using SearchCallback = std::function<void(SearchGeneration, bool finished)>;
+    SearchGeneration searchAsync(const SearchQuery &query, std::shared_ptr<SearchResultStore> store, SearchCallback callback);
     void stopSearch();
+    void waitForSearch();
+    bool isCurrentSearch(SearchGeneration generation) const;
+    // Roots, exclusions and mount policy used by the next searchAsync()
+    void setSearchScope(const SearchScopeOptions &options);
     
+    // Multi-item paste: the plan (totals, conflicts, read order) is built off
+    // the UI thread, then the whole batch runs as one job with one progress stream
+    using BatchPlanCallback = std::function<void(std::shared_ptr<BatchPlan>)>;
+    using BatchProgressCallback = BatchOperation::ProgressCallback;
+    using BatchDoneCallback = std::function<void(const BatchResult&)>;
+    void planBatchAsync(const QStringList &sources, const QString &destDir, BatchMode mode, BatchPlanCallback callback);
+    void runBatchAsync(std::shared_ptr<const BatchPlan> plan, const BatchOptions &options,
+                       BatchProgressCallback progress, BatchDoneCallback done);
+    // Re-checks a folder against the manifest left by verified copies
+    using VerifyDoneCallback = std::function<void(const VerifyReport&)>;
+    void verifyManifestAsync(const QString &dir, bool addNew, VerifyDoneCallback done);
+    // Folder mirror: the comparison doubles as the dry-run report shown
+    // before anything is written
+    using SyncPlanCallback = std::function<void(std::shared_ptr<SyncPlan>)>;
+    using SyncDoneCallback = std::function<void(const SyncResult&)>;
+    void planSyncAsync(const QString &source, const QString &destination, SyncPlanCallback callback);
+    void runSyncAsync(std::shared_ptr<const SyncPlan> plan, const SyncOptions &options,
+                      BatchProgressCallback progress, SyncDoneCallback done);
+    void cancelBatches();
+    // Blocks until every background job (batches, verifies, listings) is done
+    void waitForJobs();
+
     // File operations
     bool copy(const QString &src, const QString &dest);
     bool move(const QString &src, const QString &dest);
@@ -47,6 +94,19 @@ public:
     static QString rootPath();
 
 private:
-    QString getPermissionsString(fs::perms p);
-    std::atomic<bool> m_stopSearch{false};
+    static QString getPermissionsString(fs::perms p);
+    void runSearch(const SearchQuery &query, SearchScopeOptions options, SearchResultStore &store,
+                   const SearchSession::Token &token, const SearchCallback &callback);
+
+    void startJob(std::function<void()> job, ThreadPool &pool = ThreadPool::shared());
+
+    // Jobs in flight; cancelBatches() bumps the epoch batches were started in
+    std::atomic<quint64> m_batchEpoch{0};
+    std::mutex m_jobMutex;
+    std::condition_variable m_jobsIdle;
+    int m_jobsRunning = 0;
+
+    std::mutex m_scopeMutex;
+    SearchScopeOptions m_scopeOptions;
+    SearchSession m_search;
 };
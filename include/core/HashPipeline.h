@@ -0,0 +1,61 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Second stage of a verified copy: buffers that were just written are
+// hashed on a dedicated thread while the copy thread reads the next chunk.
+// Buffers are page aligned so they can also be used with O_DIRECT.
+// One producer thread at a time.
+class HashPipeline {
+public:
+    static constexpr std::size_t kBufferSize = 4 << 20;
+    static constexpr std::size_t kBufferCount = 4;
+
+    struct Buffer {
+        char *data;
+        std::size_t length;
+    };
+
+    HashPipeline();
+    ~HashPipeline();
+
+    HashPipeline(const HashPipeline &) = delete;
+    HashPipeline &operator=(const HashPipeline &) = delete;
+
+    // Blocks until the hasher hands a buffer back
+    Buffer *acquire();
+    // Queues buffer->length bytes for hashing; the buffer must not be touched afterwards
+    void submit(Buffer *buffer);
+    // Returns an acquired buffer that ended up unused
+    void release(Buffer *buffer);
+    // Hex SHA-256 of everything submitted since the previous finish()
+    std::string finish();
+
+    // Reads path through the pipeline. With bypassCache the file is read with
+    // O_DIRECT, or after dropping its cached pages where O_DIRECT is refused.
+    bool hashFile(const std::string &path, bool bypassCache, std::string *digest);
+
+private:
+    struct Message {
+        Buffer *buffer;                // nullptr marks the end of a stream
+        std::promise<std::string> *digest;
+    };
+
+    void hasherLoop();
+
+    std::vector<Buffer> m_buffers;
+    std::vector<Buffer *> m_free;
+    std::deque<Message> m_queue;
+    std::mutex m_mutex;
+    std::condition_variable m_queued;
+    std::condition_variable m_freed;
+    bool m_stopping = false;
+    std::thread m_hasher;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <istream>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+// What kind of filesystem a mount is, as far as walking it is concerned
+enum class MountClass {
+    Local,    // block-backed filesystems (ext4, xfs, btrfs, ...)
+    Network,  // nfs, cifs, ceph, 9p, ... - can stall for minutes
+    Fuse,     // any fuse.* mount (sshfs, gvfs, rclone, ...)
+    Overlay,  // overlay/aufs stacks (container layers)
+    Virtual   // proc, sysfs, devtmpfs, cgroup, tmpfs, ...
+};
+
+struct MountEntry {
+    dev_t device;
+    std::string mountPoint;
+    std::string fsType;
+    MountClass kind;
+};
+
+// Snapshot of /proc/self/mountinfo, parsed once per use
+class MountTable {
+public:
+    static MountTable load(const std::string &path = "/proc/self/mountinfo");
+    static MountTable parse(std::istream &in);
+    static MountClass classify(const std::string &fsType);
+
+    const std::vector<MountEntry> &entries() const { return m_entries; }
+
+private:
+    std::vector<MountEntry> m_entries;
+};
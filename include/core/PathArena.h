@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Paths stored as a tree of (parent id, name) nodes with all names packed
+// into one buffer, so a directory shared by many entries is stored once.
+// Full paths only exist when path() is asked for.
+class PathArena {
+public:
+    using NodeId = std::uint32_t;
+    static constexpr NodeId kNone = UINT32_MAX;
+
+    // Adds a child of parent; kNone makes a root, whose name is its full path
+    NodeId add(NodeId parent, std::string_view name, bool isDir);
+
+    NodeId parent(NodeId node) const { return m_nodes[node].parent; }
+    bool isDir(NodeId node) const { return m_nodes[node].length & kDirFlag; }
+    std::string_view name(NodeId node) const {
+        const Node &n = m_nodes[node];
+        return std::string_view(m_names.data() + n.offset, n.length & ~kDirFlag);
+    }
+    std::string path(NodeId node) const;
+
+    std::size_t size() const { return m_nodes.size(); }
+
+private:
+    static constexpr std::uint32_t kDirFlag = 0x80000000u;
+
+    struct Node {
+        std::uint64_t offset;
+        NodeId parent;
+        std::uint32_t length; // name length, high bit = directory
+    };
+
+    std::vector<Node> m_nodes;
+    std::string m_names;
+};
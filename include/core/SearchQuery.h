@@ -0,0 +1,73 @@
+#pragma once
+
+#include "core/DirectoryWalker.h"
+#include <QString>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Column store for one chunk of walker entries. Only the columns a plan
+// asks for are filled, and metadata columns only for rows still selected.
+struct EntryBatch {
+    const std::vector<DirectoryWalker::Entry> *entries = nullptr;
+    std::vector<std::int64_t> size;
+    std::vector<std::int64_t> mtime; // seconds since epoch
+    std::vector<std::uint32_t> mode;
+    std::vector<std::uint32_t> extId; // 0 = not an extension the plan cares about
+
+    std::size_t rows() const { return entries ? entries->size() : 0; }
+};
+
+// Parsed form of the search box, e.g. `ext:log size:>1G mtime:<7d path:/srv report`.
+//
+//   word / "two words"   name contains (case-insensitive), all terms must match
+//   ext:log,txt          extension is one of the list; repeated ext: tokens add to
+//                        the same list (ext:log ext:txt == ext:log,txt)
+//   size:>1G             size compared with <, <=, >, >=, = (K/M/G/T are 1024-based)
+//   mtime:<7d            modified less than 7 days ago (s, m, h, d, w); also mtime:>2024-01-31
+//   type:f | type:d      files or directories only
+//   mode:755             exact permission bits (octal)
+//   path:/srv            only walk below this directory (repeatable)
+//
+// All other filters AND together. Predicates are compiled once into a plan
+// ordered by estimated cost per rejected row: cheap filters that reject most
+// rows run first. Everything that can be decided from the directory entry runs
+// before anything that needs stat(), so metadata is only fetched for rows
+// that survived the cheap filters.
+class SearchQuery {
+public:
+    SearchQuery() = default;
+
+    static SearchQuery parse(const QString &text, QString *error = nullptr);
+
+    // Directories given with path:, empty means "use the configured scope"
+    const std::vector<std::string> &roots() const { return m_roots; }
+
+    // Narrows selection (row indices into batch) to the rows matching every predicate
+    void evaluate(EntryBatch &batch, int dirFd, std::vector<std::uint32_t> &selection) const;
+
+    // Ranking used for result ordering (higher is better)
+    int score(const QString &fileName, int pathLength) const;
+
+private:
+    enum class Stage { Entry, Metadata };
+
+    struct Predicate {
+        Stage stage;
+        double rank; // cost / selectivity; lower runs first
+        std::function<void(const EntryBatch &, std::vector<std::uint32_t> &)> filter;
+    };
+
+    // selectivity is the estimated fraction of rows the predicate rejects
+    void addPredicate(Stage stage, double cost, double selectivity,
+                      std::function<void(const EntryBatch &, std::vector<std::uint32_t> &)> filter);
+    void fillExtensions(EntryBatch &batch, const std::vector<std::uint32_t> &selection) const;
+    static void fillMetadata(EntryBatch &batch, int dirFd, std::vector<std::uint32_t> &selection);
+
+    std::vector<Predicate> m_predicates;
+    std::vector<std::string> m_roots;
+    std::vector<QString> m_nameTerms;
+    std::unordered_map<std::string, std::uint32_t> m_extensions; // lower-case ext -> id
+};
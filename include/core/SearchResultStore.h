@@ -0,0 +1,57 @@
+#pragma once
+
+#include "core/PathArena.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Hits of one search. A walk appends whole directories of hits at a time;
+// the UI reads concurrently and materializes paths for visible rows only.
+// Each hit costs one arena node, a score and its name bytes; directories are
+// interned once no matter how many hits they hold. The store holds at most
+// maxHits hits; once full, further hits are dropped and the walk can stop.
+class SearchResultStore {
+public:
+    static constexpr std::size_t kDefaultMaxHits = 500000;
+
+    explicit SearchResultStore(std::size_t maxHits = kDefaultMaxHits) : m_maxHits(maxHits) {}
+
+    struct NewHit {
+        std::string_view name;
+        bool isDir;
+        std::int32_t score;
+    };
+
+    // Writer side, single walk thread. Returns false once the store is full.
+    bool append(const std::string &dirPath, const std::vector<NewHit> &hits);
+
+    // Reader side
+    std::size_t hitCount() const;
+    // Hits were dropped because the cap was reached
+    bool isTruncated() const;
+    std::size_t maxHits() const { return m_maxHits; }
+    void scores(std::size_t from, std::size_t to, std::vector<std::int32_t> &out) const;
+    std::string path(std::size_t hit) const;
+    bool isDir(std::size_t hit) const;
+
+private:
+    struct Hit {
+        PathArena::NodeId node;
+        std::int32_t score;
+    };
+
+    PathArena::NodeId directoryNode(const std::string &dirPath);
+
+    mutable std::mutex m_mutex;
+    PathArena m_arena;
+    std::vector<Hit> m_hits;
+    const std::size_t m_maxHits;
+    bool m_truncated = false;
+
+    // Components of the last directory interned and their nodes. Walks are
+    // depth-first, so consecutive directories mostly share this prefix.
+    std::vector<std::pair<std::string, PathArena::NodeId>> m_chain;
+    PathArena::NodeId m_root = PathArena::kNone;
+};
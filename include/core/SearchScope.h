@@ -0,0 +1,64 @@
+#pragma once
+
+#include "core/MountTable.h"
+#include <string>
+#include <sys/types.h>
+#include <unordered_set>
+#include <vector>
+
+struct SearchScopeOptions {
+    std::vector<std::string> roots{"/"};
+    // Subtrees never entered; resolved once to (device, inode)
+    std::vector<std::string> excludedPaths{"/tmp", "/mnt", "/media"};
+    // Stay on the device each root lives on (like find -xdev)
+    bool oneFileSystem = false;
+    bool includeNetwork = false;
+    bool includeFuse = false;
+    bool includeOverlay = false;
+    bool includeVirtual = false;
+};
+
+// Decides which directories a global search may enter. Mounts are excluded
+// by device number taken from the mount table, user exclusions by the
+// (device, inode) of their directory, so each check is a hash lookup
+// instead of a scan over path prefixes. Excluded mount points are also
+// known by path, so the walker can skip them without stat()ing a mount root
+// that may hang (a dead hard NFS mount).
+class SearchScope {
+public:
+    struct Root {
+        std::string path;
+        dev_t device;
+        ino_t inode;
+    };
+
+    SearchScope(const MountTable &mounts, const SearchScopeOptions &options);
+
+    // Roots that exist and are not themselves excluded, deduplicated
+    const std::vector<Root> &roots() const { return m_roots; }
+
+    // Whether a directory reached from a root on rootDevice should be walked
+    bool admits(dev_t device, ino_t inode, dev_t rootDevice) const;
+    // Path-only pre-check, done before any stat of the directory
+    bool excludesPath(const std::string &path) const { return m_excludedPaths.count(path) != 0; }
+
+private:
+    struct DevIno {
+        dev_t device;
+        ino_t inode;
+        bool operator==(const DevIno &o) const { return device == o.device && inode == o.inode; }
+    };
+    struct DevInoHash {
+        std::size_t operator()(const DevIno &k) const {
+            return std::hash<dev_t>()(k.device) * 31 + std::hash<ino_t>()(k.inode);
+        }
+    };
+
+    std::vector<Root> m_roots;
+    std::unordered_set<dev_t> m_excludedDevices;
+    std::unordered_set<DevIno, DevInoHash> m_excludedDirs;
+    std::unordered_set<std::string> m_excludedPaths; // excluded mount points and user exclusions
+    // Roots nested inside other roots are only walked from their own entry
+    std::unordered_set<DevIno, DevInoHash> m_rootDirs;
+    bool m_oneFileSystem;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "core/ThreadPool.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+// Owns the lifetime of global search walks. Every start() opens a new
+// generation; older generations observe cancellation on their next poll and
+// their results are rejected by isCurrent(). Walks run on a shared pool and
+// are always waited for before the session goes away.
+class SearchSession {
+public:
+    using Generation = std::uint64_t;
+
+    // Handed to a running walk; cheap enough to poll once per entry
+    class Token {
+    public:
+        Generation generation() const { return m_generation; }
+        bool cancelled() const { return m_current->load(std::memory_order_relaxed) != m_generation; }
+
+    private:
+        friend class SearchSession;
+        Token(const std::atomic<Generation> *current, Generation generation)
+            : m_current(current), m_generation(generation) {}
+
+        const std::atomic<Generation> *m_current;
+        Generation m_generation;
+    };
+
+    using Job = std::function<void(const Token &)>;
+
+    explicit SearchSession(ThreadPool &pool = ThreadPool::shared());
+    ~SearchSession();
+
+    SearchSession(const SearchSession &) = delete;
+    SearchSession &operator=(const SearchSession &) = delete;
+
+    // Supersedes whatever is running and schedules job under a fresh generation
+    Generation start(Job job);
+    void cancel();
+    // Blocks until every walk (current or superseded) has returned
+    void wait();
+
+    bool isCurrent(Generation generation) const {
+        return m_current.load(std::memory_order_acquire) == generation;
+    }
+
+private:
+    ThreadPool &m_pool;
+    std::atomic<Generation> m_current{0};
+
+    std::mutex m_mutex;
+    std::condition_variable m_idle;
+    int m_running = 0;
+};
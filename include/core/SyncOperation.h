@@ -0,0 +1,61 @@
+#pragma once
+
+#include "core/BatchOperation.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct SyncOptions {
+    // Remove destination entries that no longer exist in the source, and
+    // entries the source has with another type. Off, those are left alone
+    // and reported as failures.
+    bool deleteExtra = true;
+};
+
+struct SyncItem {
+    enum Action { CreateDir, Create, Update, Symlink, Delete };
+
+    Action action;
+    std::string relative;  // path below both roots
+    std::uint64_t size = 0;
+    bool replace = false;  // destination exists with another type; removed first, counts as a delete
+};
+
+// Dry-run result of comparing two trees; run() only carries it out
+struct SyncPlan {
+    std::string source;
+    std::string destination;
+    // Deletions, then directories in pre-order, then files
+    std::vector<SyncItem> items;
+    std::size_t creates = 0;
+    std::size_t updates = 0;
+    std::size_t deletes = 0;   // includes replacements
+    std::size_t replaces = 0;
+    std::size_t unchanged = 0;
+    std::uint64_t createBytes = 0;
+    std::uint64_t updateBytes = 0;    // size of changed files; only differing blocks get written
+    std::uint64_t unchangedBytes = 0;
+    std::vector<std::string> errors;
+};
+
+struct SyncResult {
+    bool cancelled = false;
+    std::uint64_t bytesWritten = 0;
+    std::uint64_t bytesMatched = 0;  // blocks of updated files that were already identical
+    std::vector<std::string> failures;
+};
+
+// One-way mirror of a source folder into a destination folder. Files whose
+// size and mtime match are skipped without being opened; changed files that
+// are large enough are compared block by block and patched in place.
+class SyncOperation {
+public:
+    static constexpr std::size_t kBlockSize = 1 << 20;
+    // Smaller files are rewritten whole; comparing them costs more than it saves
+    static constexpr std::uint64_t kDeltaThreshold = 8 << 20;
+
+    static SyncPlan plan(const std::string &source, const std::string &destination);
+    static SyncResult run(const SyncPlan &plan, const SyncOptions &options,
+                          const BatchOperation::ProgressCallback &progress, const BatchOperation::CancelCheck &cancelled);
+};
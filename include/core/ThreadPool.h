@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size worker pool shared by long-running engine jobs (search walks,
+// batch copies). Workers are joined on destruction; nothing is ever detached.
+class ThreadPool {
+public:
+    explicit ThreadPool(std::size_t workers);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Process-wide pool, bounded to the hardware concurrency (at least 2, at most 8)
+    static ThreadPool &shared();
+    // Separate pool for fanning bulk file I/O out (sync), so searches and
+    // batch jobs on shared() never queue behind it
+    static ThreadPool &bulk();
+    // Two workers for directory listings only: opening a folder must not wait
+    // for a copy, sync or search to free a shared() worker
+    static ThreadPool &listing();
+
+    template <typename Fn>
+    auto submit(Fn &&fn) -> std::future<decltype(fn())> {
+        using R = decltype(fn());
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<Fn>(fn));
+        std::future<R> result = task->get_future();
+        enqueue([task]() { (*task)(); });
+        return result;
+    }
+
+    // Runs fn(0..count-1) on the calling thread plus any idle workers and
+    // returns when all indices are done. The caller never waits for a helper
+    // that has not started, so this is safe to call from inside a pool job.
+    // fn must not throw.
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)> &fn);
+
+    std::size_t size() const { return m_workers.size(); }
+
+private:
+    void enqueue(std::function<void()> job);
+    void workerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_queue;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stopping = false;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QIcon>
+#include <QSet>
+#include <QTimer>
+#include <QVector>
+#include "core/DirectoryWatcher.h"
+#include "core/FileSystemEngine.h"
+
+// Flat listing of one directory for the main view. The initial listing is
+// read off the UI thread; after that the model follows the directory
+// through DirectoryWatcher and applies per-entry insert/remove/update rows
+// instead of relisting. A directory that cannot be watched is polled.
+class DirectoryModel : public QAbstractTableModel {
+    Q_OBJECT
+public:
+    enum Column { NameColumn, SizeColumn, TypeColumn, ModifiedColumn, ColumnCount };
+
+    explicit DirectoryModel(FileSystemEngine *engine, QObject *parent = nullptr);
+
+    void setIcons(const QIcon &folder, const QIcon &file);
+
+    void setDirectory(const QString &path);
+    QString directory() const { return m_path; }
+    void reload();
+
+    void setShowHidden(bool show);
+    bool showHidden() const { return m_showHidden; }
+
+    QString filePath(const QModelIndex &index) const;
+    QString fileName(const QModelIndex &index) const;
+    bool isDir(const QModelIndex &index) const;
+    // Row of an entry of the current directory, invalid if not listed (yet)
+    QModelIndex indexOf(const QString &path) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+signals:
+    void directoryLoaded(const QString &path);
+
+private:
+    // Relist interval when the directory cannot be watched (inotify limits,
+    // filesystems without notifications)
+    static constexpr int kPollMs = 3000;
+
+    bool lessThan(const FileInfo &a, const FileInfo &b) const;
+    int rowOf(const QString &name) const;
+    int insertPosition(const FileInfo &info) const;
+    void applyListing(quint64 generation, QVector<FileInfo> entries);
+    void applyChanges(const QStringList &names);
+    void poll();
+    void applyPoll(quint64 generation, const QVector<FileInfo> &entries);
+
+    FileSystemEngine *m_engine;
+    DirectoryWatcher *m_watcher;
+    QTimer *m_pollTimer;
+    QString m_path;
+    quint64 m_generation = 0;
+    bool m_listing = false;
+    QSet<QString> m_heldChanges;  // flushed while a listing was in flight
+    bool m_showHidden = false;
+    int m_sortColumn = NameColumn;
+    Qt::SortOrder m_sortOrder = Qt::AscendingOrder;
+
+    QVector<FileInfo> m_rows;           // sorted by lessThan
+    QHash<QString, FileInfo> m_byName;  // sort keys of listed rows
+    QIcon m_folderIcon;
+    QIcon m_fileIcon;
+};
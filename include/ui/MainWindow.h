@@ -2,7 +2,6 @@
 
 #include <QMainWindow>
 #include <QTreeView>
-#include <QFileSystemModel>
 #include <QLineEdit>
 #include <QPushButton>
 #include <QVBoxLayout>
@@ -11,18 +10,26 @@
 #include <QStatusBar>
 #include <QAction>
 #include <QListWidget>
+#include <QListView>
 #include <QStackedWidget>
 #include "core/FileSystemEngine.h"
+#include "ui/DirectoryModel.h"
+#include "ui/SearchResultModel.h"
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
 public:
     explicit MainWindow(QWidget *parent = nullptr);
+    ~MainWindow() override;
+
+    // Exposed for the --startup-probe timing in main.cpp
+    QTreeView *fileView() const { return m_treeView; }
+    DirectoryModel *fileModel() const { return m_model; }
 
 private slots:
     void onDirectoryLoaded(const QString &path);
     void onFileDoubleClicked(const QModelIndex &index);
-    void onSearchResultClicked(QListWidgetItem *item);
+    void onSearchResultClicked(const QModelIndex &item);
     void onSideBarClicked(QListWidgetItem *item);
     void startGlobalSearch();
     void showContextMenu(const QPoint &pos);
@@ -42,26 +49,37 @@ private slots:
     void copySelected();
     void cutSelected();
     void pasteToCurrent();
+    void verifyChecksums();
+    void addChecksums();
+    void syncTo();
 
 private:
     void setupUI();
     void setupSidebar();
+    void ensureSearchList();
     void setupActions();
     void setupShortcuts();
     void applyModernStyle();
+    QStringList selectedPaths() const;
+    void onBatchPlanned(std::shared_ptr<BatchPlan> plan);
+    void runVerify(bool addNew);
+    void onSyncPlanned(std::shared_ptr<SyncPlan> plan);
     
     FileSystemEngine *m_engine;
     
     QStackedWidget *m_stackWidget;
     QTreeView *m_treeView;
-    QListWidget *m_searchList;
+    QListView *m_searchList;
+    SearchResultModel *m_searchModel;
     QListWidget *m_sideBar;
     
-    QFileSystemModel *m_model;
+    DirectoryModel *m_model;
     QLineEdit *m_pathEdit;
     QLineEdit *m_searchEdit;
     QToolBar *m_toolBar;
+    QAction *m_verifyAct;
     
-    QString m_copyPath;
+    QString m_pendingSelection; // search hit to select once its folder is listed
+    QStringList m_clipboard;
     bool m_isCut;
 };
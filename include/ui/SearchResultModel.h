@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QIcon>
+#include <memory>
+#include <vector>
+#include "core/SearchResultStore.h"
+
+// List model over a SearchResultStore. While a walk runs, each batch of new
+// hits is appended best-first; the full ranking by descending score is
+// applied once when the walk ends. Rows only hold hit indices; paths are
+// built in data() for rows being drawn.
+class SearchResultModel : public QAbstractListModel {
+    Q_OBJECT
+public:
+    explicit SearchResultModel(QObject *parent = nullptr);
+
+    void setIcons(const QIcon &folder, const QIcon &file);
+    void setStore(std::shared_ptr<const SearchResultStore> store);
+    // Pulls hits appended since the last call; finished ranks all rows
+    void refresh(bool finished = false);
+
+    QString filePath(const QModelIndex &index) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+private:
+    bool byScore(std::uint32_t a, std::uint32_t b) const;
+    void rankAll();
+
+    std::shared_ptr<const SearchResultStore> m_store;
+    std::vector<std::uint32_t> m_order; // hit indices, best score first
+    std::vector<std::int32_t> m_scores; // score per hit index
+    QIcon m_folderIcon;
+    QIcon m_fileIcon;
+};
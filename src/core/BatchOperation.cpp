@@ -0,0 +1,486 @@
+#include "core/BatchOperation.h"
+#include "core/ChecksumManifest.h"
+#include "core/HashPipeline.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <linux/fiemap.h>
+#include <linux/fs.h>
+#include <memory>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+// Physical byte offset of the first extent, used only as a sort key
+static std::uint64_t firstPhysicalExtent(int fd) {
+    alignas(struct fiemap) unsigned char buffer[sizeof(struct fiemap) + sizeof(struct fiemap_extent)] = {};
+    auto *map = reinterpret_cast<struct fiemap *>(buffer);
+    map->fm_start = 0;
+    map->fm_length = FIEMAP_MAX_OFFSET;
+    map->fm_extent_count = 1;
+    if (::ioctl(fd, FS_IOC_FIEMAP, map) != 0 || map->fm_mapped_extents == 0) return 0;
+    return map->fm_extents[0].fe_physical;
+}
+
+static bool isInside(const fs::path &child, const fs::path &parent) {
+    std::error_code ec;
+    const std::string c = fs::weakly_canonical(child, ec).string();
+    const std::string p = fs::weakly_canonical(parent, ec).string();
+    return c == p || (c.size() > p.size() && c.compare(0, p.size(), p) == 0 && (p.back() == '/' || c[p.size()] == '/'));
+}
+
+// "report.txt" pasted next to itself becomes "report (copy).txt", then "(copy 2)", ...
+static fs::path uniqueCopyName(const fs::path &dir, const std::string &name) {
+    const auto dot = name.rfind('.');
+    const bool hasExt = dot != std::string::npos && dot != 0;
+    const std::string stem = hasExt ? name.substr(0, dot) : name;
+    const std::string ext = hasExt ? name.substr(dot) : std::string();
+    struct stat st;
+    for (int n = 1;; ++n) {
+        fs::path candidate = dir / (stem + (n == 1 ? " (copy)" : " (copy " + std::to_string(n) + ")") + ext);
+        if (::lstat(candidate.c_str(), &st) != 0) return candidate;
+    }
+}
+
+static void addEntry(BatchPlan &plan, const fs::path &source, const fs::path &destination, const struct stat &st) {
+    BatchItem item;
+    item.source = source.string();
+    item.destination = destination.string();
+    item.device = st.st_dev;
+    item.inode = st.st_ino;
+
+    struct stat existing;
+    const bool exists = ::lstat(item.destination.c_str(), &existing) == 0;
+
+    if (S_ISDIR(st.st_mode)) {
+        item.kind = BatchItem::Directory;
+        // Merging into an existing directory is not a conflict
+        if (exists && !S_ISDIR(existing.st_mode)) {
+            plan.errors.push_back(item.destination + ": exists and is not a directory");
+            return;
+        }
+    } else if (S_ISLNK(st.st_mode)) {
+        item.kind = BatchItem::Symlink;
+        item.conflict = exists;
+        ++plan.totalFiles;
+    } else if (S_ISREG(st.st_mode)) {
+        // A destination hard-linked (or symlinked) to the source is the source:
+        // truncating it for the copy would empty both (cp -al / --link-dest trees)
+        struct stat target;
+        if (exists && ::stat(item.destination.c_str(), &target) == 0 && target.st_dev == st.st_dev &&
+            target.st_ino == st.st_ino) {
+            plan.errors.push_back(item.destination + ": is the same file as the source");
+            return;
+        }
+        item.kind = BatchItem::File;
+        item.size = static_cast<std::uint64_t>(st.st_size);
+        item.conflict = exists;
+        int fd = ::open(item.source.c_str(), O_RDONLY | O_CLOEXEC | O_NOATIME);
+        if (fd < 0) fd = ::open(item.source.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            item.physical = firstPhysicalExtent(fd);
+            ::close(fd);
+        }
+        plan.totalBytes += item.size;
+        ++plan.totalFiles;
+    } else {
+        plan.errors.push_back(item.source + ": not a regular file, directory or symlink");
+        return;
+    }
+    if (item.conflict) ++plan.conflicts;
+    plan.items.push_back(std::move(item));
+}
+
+// rename() cannot replace a non-empty folder, so a folder moved onto an
+// existing one is merged into it entry by entry; the emptied source tree is
+// left for removeAfter. Returns whether it merged.
+static bool addRenames(BatchPlan &plan, const fs::path &source, const fs::path &destination, const struct stat &st) {
+    struct stat existing;
+    const bool exists = ::lstat(destination.c_str(), &existing) == 0;
+
+    if (exists && S_ISDIR(st.st_mode) && S_ISDIR(existing.st_mode)) {
+        BatchItem item;
+        item.kind = BatchItem::Directory;
+        item.source = source.string();
+        item.destination = destination.string();
+        item.device = st.st_dev;
+        item.inode = st.st_ino;
+        plan.items.push_back(std::move(item));
+
+        std::error_code ec;
+        for (auto it = fs::directory_iterator(source, fs::directory_options::none, ec);
+             !ec && it != fs::directory_iterator(); it.increment(ec)) {
+            struct stat entry;
+            if (::lstat(it->path().c_str(), &entry) != 0) continue;
+            addRenames(plan, it->path(), destination / it->path().filename(), entry);
+        }
+        if (ec) plan.errors.push_back(source.string() + ": " + ec.message());
+        return true;
+    }
+
+    if (exists && S_ISDIR(existing.st_mode) != S_ISDIR(st.st_mode)) {
+        plan.errors.push_back(destination.string() + (S_ISDIR(st.st_mode) ? ": exists and is not a directory"
+                                                                          : ": exists and is a directory"));
+        return false;
+    }
+    if (exists && existing.st_dev == st.st_dev && existing.st_ino == st.st_ino) {
+        plan.errors.push_back(destination.string() + ": is the same file as the source");
+        return false;
+    }
+
+    BatchItem item;
+    item.kind = BatchItem::Rename;
+    item.source = source.string();
+    item.destination = destination.string();
+    item.device = st.st_dev;
+    item.inode = st.st_ino;
+    item.conflict = exists;
+    if (item.conflict) ++plan.conflicts;
+    ++plan.totalFiles;
+    plan.items.push_back(std::move(item));
+    return false;
+}
+
+BatchPlan BatchOperation::plan(const std::vector<std::string> &sources, const std::string &destDir, BatchMode mode) {
+    BatchPlan plan;
+    plan.mode = mode;
+    plan.destination = destDir;
+
+    struct stat destStat;
+    if (::stat(destDir.c_str(), &destStat) != 0 || !S_ISDIR(destStat.st_mode)) {
+        plan.errors.push_back(destDir + ": not a directory");
+        return plan;
+    }
+
+    for (const auto &raw : sources) {
+        // "dir/" and "dir" are the same source; "/" cannot be pasted anywhere
+        fs::path source = fs::path(raw).lexically_normal();
+        if (!source.has_filename()) source = source.parent_path();
+        const std::string src = source.string();
+        if (!source.has_filename() || source == source.root_path()) {
+            plan.errors.push_back(raw + ": cannot copy or move a filesystem root");
+            continue;
+        }
+        struct stat st;
+        if (::lstat(source.c_str(), &st) != 0) {
+            plan.errors.push_back(src + ": no longer exists");
+            continue;
+        }
+        if (S_ISDIR(st.st_mode) && isInside(destDir, source)) {
+            plan.errors.push_back(src + ": cannot paste a folder into itself");
+            continue;
+        }
+
+        fs::path destination = fs::path(destDir) / source.filename();
+        std::error_code ec;
+        if (fs::equivalent(source, destination, ec)) {
+            if (mode == BatchMode::Move) continue; // moving onto itself is a no-op
+            destination = uniqueCopyName(destDir, source.filename().string());
+        }
+
+        // Same filesystem: a move is a single rename of the top-level entry,
+        // or one per entry when it has to be merged into an existing folder
+        if (mode == BatchMode::Move && st.st_dev == destStat.st_dev) {
+            if (addRenames(plan, source, destination, st)) plan.removeAfter.push_back(src);
+            continue;
+        }
+
+        addEntry(plan, source, destination, st);
+        if (S_ISDIR(st.st_mode)) {
+            ec.clear();
+            // Unreadable subtrees are reported rather than skipped: a move must
+            // never delete what it could not copy
+            for (auto it = fs::recursive_directory_iterator(source, fs::directory_options::none, ec);
+                 !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+                struct stat entry;
+                if (::lstat(it->path().c_str(), &entry) != 0) continue;
+                addEntry(plan, it->path(), destination / it->path().lexically_relative(source), entry);
+            }
+            if (ec) plan.errors.push_back(src + ": " + ec.message());
+        }
+        if (mode == BatchMode::Move) plan.removeAfter.push_back(src);
+    }
+
+    // Directories keep their pre-order so parents exist before children;
+    // everything else is read in device / on-disk order to cut seeks
+    auto firstLeaf = std::stable_partition(plan.items.begin(), plan.items.end(), [](const BatchItem &item) {
+        return item.kind == BatchItem::Directory;
+    });
+    std::stable_sort(firstLeaf, plan.items.end(), [](const BatchItem &a, const BatchItem &b) {
+        if (a.device != b.device) return a.device < b.device;
+        // Files without extent info (tmpfs, FIEMAP unsupported) go by inode
+        if ((a.physical != 0) != (b.physical != 0)) return a.physical != 0;
+        if (a.physical != b.physical) return a.physical < b.physical;
+        return a.inode < b.inode;
+    });
+    return plan;
+}
+
+bool BatchOperation::copyData(int in, int out, const std::function<void(std::uint64_t)> &advance,
+                              const CancelCheck &cancelled) {
+    constexpr std::size_t kChunk = 8 << 20;
+    bool useRange = true;
+    std::vector<char> buffer;
+
+    for (;;) {
+        if (cancelled()) return false;
+        ssize_t n;
+        if (useRange) {
+            n = ::copy_file_range(in, nullptr, out, nullptr, kChunk, 0);
+            if (n < 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)) {
+                useRange = false;
+                continue;
+            }
+        } else {
+            if (buffer.empty()) buffer.resize(1 << 20);
+            n = ::read(in, buffer.data(), buffer.size());
+            for (ssize_t written = 0; n > 0 && written < n;) {
+                ssize_t w = ::write(out, buffer.data() + written, n - written);
+                if (w < 0) {
+                    if (errno == EINTR) continue;
+                    return false;
+                }
+                written += w;
+            }
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (n == 0) return true;
+        advance(static_cast<std::uint64_t>(n));
+    }
+}
+
+// Verified variant of copyData: every chunk goes through the hash pipeline
+// right after it was written, so hashing overlaps the next read
+static bool copyDataHashed(int in, int out, HashPipeline &pipeline, std::string *digest,
+                           const std::function<void(std::uint64_t)> &advance,
+                           const BatchOperation::CancelCheck &cancelled) {
+    bool ok = true;
+    for (;;) {
+        if (cancelled()) {
+            ok = false;
+            break;
+        }
+        HashPipeline::Buffer *buffer = pipeline.acquire();
+        ssize_t n = ::read(in, buffer->data, HashPipeline::kBufferSize);
+        if (n < 0 && errno == EINTR) {
+            pipeline.release(buffer);
+            continue;
+        }
+        if (n <= 0) {
+            pipeline.release(buffer);
+            ok = n == 0;
+            break;
+        }
+        for (ssize_t written = 0; ok && written < n;) {
+            ssize_t w = ::write(out, buffer->data + written, n - written);
+            if (w < 0 && errno != EINTR) ok = false;
+            if (w > 0) written += w;
+        }
+        if (!ok) {
+            pipeline.release(buffer);
+            break;
+        }
+        buffer->length = static_cast<std::size_t>(n);
+        pipeline.submit(buffer);
+        advance(static_cast<std::uint64_t>(n));
+    }
+    std::string result = pipeline.finish();
+    if (ok) *digest = std::move(result);
+    return ok;
+}
+
+int BatchOperation::openSource(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NOATIME);
+    if (fd < 0) fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    return fd;
+}
+
+BatchResult BatchOperation::run(const BatchPlan &plan, const BatchOptions &options,
+                                const ProgressCallback &progress, const CancelCheck &cancelled) {
+    const ConflictPolicy policy = options.conflicts;
+    std::unique_ptr<HashPipeline> pipeline;
+    ChecksumManifest manifest;
+    if (options.verify) {
+        pipeline = std::make_unique<HashPipeline>();
+        manifest.load(ChecksumManifest::pathFor(plan.destination));
+    }
+
+    BatchResult result;
+    BatchProgress state;
+    state.bytesTotal = plan.totalBytes;
+    state.filesTotal = plan.totalFiles;
+
+    using Clock = std::chrono::steady_clock;
+    auto lastReport = Clock::now();
+    auto report = [&](bool force) {
+        const auto now = Clock::now();
+        if (!force && now - lastReport < std::chrono::milliseconds(100)) return;
+        lastReport = now;
+        if (progress) progress(state);
+    };
+    auto advance = [&](std::uint64_t bytes) {
+        state.bytesDone += bytes;
+        report(false);
+    };
+    auto fail = [&](const BatchItem &item) {
+        result.failures.push_back(item.source + ": " + std::strerror(errno));
+    };
+
+    // One-file lookahead: the next source is opened and its readahead started
+    // while the current one is still being copied
+    std::size_t skipped = 0;
+    int prefetched = -1;
+    std::size_t prefetchedIndex = plan.items.size();
+    auto prefetch = [&](std::size_t from) {
+        for (std::size_t j = from; j < plan.items.size(); ++j) {
+            const BatchItem &next = plan.items[j];
+            if (next.kind != BatchItem::File) continue;
+            if (next.conflict && policy == ConflictPolicy::Skip) continue;
+            prefetched = openSource(next.source);
+            prefetchedIndex = j;
+            if (prefetched >= 0) ::posix_fadvise(prefetched, 0, 0, POSIX_FADV_WILLNEED);
+            return;
+        }
+    };
+
+    for (std::size_t i = 0; i < plan.items.size(); ++i) {
+        if (cancelled()) {
+            result.cancelled = true;
+            break;
+        }
+        const BatchItem &item = plan.items[i];
+        state.current = item.source;
+
+        if (item.conflict && policy == ConflictPolicy::Skip) {
+            ++skipped;
+            state.bytesDone += item.size;
+            ++state.filesDone;
+            report(false);
+            continue;
+        }
+
+        switch (item.kind) {
+        case BatchItem::Directory: {
+            struct stat st;
+            if (::mkdir(item.destination.c_str(), 0777) != 0 &&
+                !(errno == EEXIST && ::stat(item.destination.c_str(), &st) == 0 && S_ISDIR(st.st_mode))) {
+                fail(item);
+            }
+            break;
+        }
+        case BatchItem::Rename:
+            if (::rename(item.source.c_str(), item.destination.c_str()) != 0) fail(item);
+            ++state.filesDone;
+            break;
+        case BatchItem::Symlink: {
+            std::error_code ec;
+            const fs::path target = fs::read_symlink(item.source, ec);
+            if (!ec && item.conflict) ::unlink(item.destination.c_str());
+            if (ec || ::symlink(target.c_str(), item.destination.c_str()) != 0) {
+                if (ec) errno = ec.value();
+                fail(item);
+            }
+            ++state.filesDone;
+            break;
+        }
+        case BatchItem::File: {
+            int in = prefetchedIndex == i ? prefetched : openSource(item.source);
+            prefetched = -1;
+            prefetchedIndex = plan.items.size();
+            if (in < 0) {
+                fail(item);
+                state.bytesDone += item.size;
+                ++state.filesDone;
+                break;
+            }
+            ::posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+            prefetch(i + 1);
+
+            struct stat st, existing;
+            ::fstat(in, &st);
+            // Re-checked here: the destination may have been linked since planning
+            if (::stat(item.destination.c_str(), &existing) == 0 && existing.st_dev == st.st_dev &&
+                existing.st_ino == st.st_ino) {
+                result.failures.push_back(item.destination + ": is the same file as the source");
+                ::close(in);
+                state.bytesDone += item.size;
+                ++state.filesDone;
+                break;
+            }
+            int out = ::open(item.destination.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, st.st_mode & 07777);
+            if (out < 0) {
+                fail(item);
+                ::close(in);
+                state.bytesDone += item.size;
+                ++state.filesDone;
+                break;
+            }
+
+            const std::uint64_t before = state.bytesDone;
+            std::string digest;
+            bool ok = pipeline ? copyDataHashed(in, out, *pipeline, &digest, advance, cancelled)
+                               : copyData(in, out, advance, cancelled);
+            if (ok) {
+                // Keep mtimes so later comparisons by size + mtime hold
+                const struct timespec times[2] = {st.st_atim, st.st_mtim};
+                ::futimens(out, times);
+            } else if (!cancelled()) {
+                fail(item);
+            }
+            if (ok && pipeline) {
+                // Flush and evict the copy so the check reads the medium, not our own writes
+                ::fdatasync(out);
+                ::posix_fadvise(out, 0, 0, POSIX_FADV_DONTNEED);
+            }
+            ::close(out);
+            ::close(in);
+
+            if (ok && pipeline) {
+                std::string written;
+                if (!pipeline->hashFile(item.destination, true, &written)) {
+                    fail(item);
+                } else if (written != digest) {
+                    result.failures.push_back(item.destination + ": checksum mismatch after copy");
+                } else {
+                    ++result.verified;
+                    ManifestEntry entry;
+                    entry.digest = std::move(digest);
+                    entry.size = static_cast<std::uint64_t>(st.st_size);
+                    entry.mtimeNs = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+                    manifest.set(fs::path(item.destination).lexically_relative(plan.destination).string(), std::move(entry));
+                }
+            }
+            if (!ok) ::unlink(item.destination.c_str());
+            // Files that changed size since planning must not skew the total
+            state.bytesDone = before + item.size;
+            ++state.filesDone;
+            if (!ok && cancelled()) result.cancelled = true;
+            break;
+        }
+        }
+        report(false);
+        if (result.cancelled) break;
+    }
+    if (prefetched >= 0) ::close(prefetched);
+
+    if (result.verified > 0) manifest.save(ChecksumManifest::pathFor(plan.destination));
+
+    // Sources of a cross-device move go only when every byte made it over
+    if (!result.cancelled && result.failures.empty() && plan.errors.empty() && skipped == 0) {
+        for (const auto &src : plan.removeAfter) {
+            std::error_code ec;
+            fs::remove_all(src, ec);
+            if (ec) result.failures.push_back(src + ": " + ec.message());
+        }
+    }
+    report(true);
+    return result;
+}
@@ -0,0 +1,162 @@
+#include "core/ChecksumManifest.h"
+#include "core/HashPipeline.h"
+#include <cerrno>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+
+// File names may hold newlines; keep one entry per line
+static std::string escapePath(const std::string &path) {
+    std::string out;
+    for (char c : path) {
+        if (c == '\\') out += "\\\\";
+        else if (c == '\n') out += "\\n";
+        else out += c;
+    }
+    return out;
+}
+
+static std::string unescapePath(const std::string &path) {
+    std::string out;
+    for (std::size_t i = 0; i < path.size(); ++i) {
+        if (path[i] == '\\' && i + 1 < path.size()) {
+            out += path[i + 1] == 'n' ? '\n' : path[i + 1];
+            ++i;
+        } else {
+            out += path[i];
+        }
+    }
+    return out;
+}
+
+bool ChecksumManifest::load(const std::string &path) {
+    m_entries.clear();
+    std::ifstream in(path);
+    if (!in) return false;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        ManifestEntry entry;
+        if (!(fields >> entry.digest >> entry.size >> entry.mtimeNs)) continue;
+        fields.get(); // single separator before the path
+        std::string rel;
+        std::getline(fields, rel);
+        if (!rel.empty()) m_entries[unescapePath(rel)] = std::move(entry);
+    }
+    return true;
+}
+
+bool ChecksumManifest::save(const std::string &path) const {
+    // Write beside the target and rename so a crash never leaves half a manifest
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        if (!out) return false;
+        out << "# raefile manifest v1: sha256 size mtime-ns path\n";
+        for (const auto &[rel, entry] : m_entries) {
+            out << entry.digest << "  " << entry.size << ' ' << entry.mtimeNs << ' ' << escapePath(rel) << '\n';
+        }
+        if (!out.flush()) return false;
+    }
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+const ManifestEntry *ChecksumManifest::find(const std::string &relPath) const {
+    auto it = m_entries.find(relPath);
+    return it == m_entries.end() ? nullptr : &it->second;
+}
+
+bool ChecksumManifest::isManifestFile(const std::string &name) {
+    const std::string base(kFileName);
+    return name == base || name == base + ".tmp";
+}
+
+// False when path is no longer a regular file; errno is EACCES only when
+// that could not be determined
+static bool currentEntry(const std::string &path, ManifestEntry *entry) {
+    struct stat st;
+    if (::lstat(path.c_str(), &st) != 0) return false;
+    if (!S_ISREG(st.st_mode)) {
+        errno = ENOENT;
+        return false;
+    }
+    entry->size = static_cast<std::uint64_t>(st.st_size);
+    entry->mtimeNs = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    return true;
+}
+
+VerifyReport ChecksumManifest::verify(const std::string &dir, HashPipeline &pipeline, bool addNew,
+                                      const std::function<bool()> &cancelled) {
+    VerifyReport report;
+    ChecksumManifest manifest;
+    const std::string manifestPath = pathFor(dir);
+    manifest.load(manifestPath);
+
+    // Tracked files only: nothing else under the folder is read
+    std::vector<std::string> gone;
+    for (auto &[rel, known] : manifest.m_entries) {
+        if (cancelled()) {
+            report.cancelled = true;
+            break;
+        }
+        const std::string path = dir + "/" + rel;
+        ManifestEntry current;
+        if (!currentEntry(path, &current)) {
+            // An unreadable parent is not proof the file is gone
+            if (errno == EACCES) report.unreadable.push_back(rel);
+            else gone.push_back(rel);
+            continue;
+        }
+        if (!pipeline.hashFile(path, true, &current.digest)) {
+            report.unreadable.push_back(rel);
+            continue;
+        }
+
+        if (known.size != current.size || known.mtimeNs != current.mtimeNs) {
+            report.changed.push_back(rel);
+            known = std::move(current);
+        } else if (known.digest != current.digest) {
+            // Keep the recorded digest: the file is damaged, not updated
+            report.corrupt.push_back(rel);
+        } else {
+            ++report.verified;
+        }
+    }
+    if (!report.cancelled) {
+        for (const auto &rel : gone) {
+            manifest.m_entries.erase(rel);
+            report.missing.push_back(rel);
+        }
+    }
+
+    // Opt-in: record files the manifest does not know yet
+    if (addNew && !report.cancelled) {
+        std::error_code ec;
+        for (auto it = fs::recursive_directory_iterator(dir, fs::directory_options::skip_permission_denied, ec);
+             !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (cancelled()) {
+                report.cancelled = true;
+                break;
+            }
+            // Nested folders carry manifests of their own
+            if (isManifestFile(it->path().filename().string())) continue;
+            const std::string rel = it->path().lexically_relative(dir).string();
+            if (manifest.find(rel)) continue;
+
+            ManifestEntry current;
+            if (!currentEntry(it->path().string(), &current)) continue;
+            if (!pipeline.hashFile(it->path().string(), true, &current.digest)) continue;
+            report.added.push_back(rel);
+            manifest.set(rel, std::move(current));
+        }
+    }
+
+    manifest.save(manifestPath);
+    return report;
+}
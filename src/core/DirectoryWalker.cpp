@@ -0,0 +1,79 @@
+#include "core/DirectoryWalker.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+void DirectoryWalker::walk(const Visitor &visit, const CancelCheck &cancelled) const {
+    struct Pending {
+        std::string path;
+        dev_t rootDevice;
+        dev_t device; // identity admitted when the directory was found
+        ino_t inode;
+        bool isRoot;
+    };
+
+    std::vector<Pending> stack;
+    std::vector<Entry> chunk;
+    chunk.reserve(kChunkSize);
+
+    for (const auto &root : m_scope.roots()) {
+        stack.push_back({root.path, root.device, root.device, root.inode, true});
+
+        while (!stack.empty()) {
+            if (cancelled()) return;
+
+            Pending dir = std::move(stack.back());
+            stack.pop_back();
+
+            // Roots may legitimately be symlinks; below them a directory
+            // swapped for a symlink (or anything else) since it was admitted
+            // must not lead the walk out of scope
+            int fd = ::open(dir.path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC | (dir.isRoot ? 0 : O_NOFOLLOW));
+            if (fd < 0) continue; // permission denied, vanished, ...
+            struct stat opened;
+            if (::fstat(fd, &opened) != 0 || opened.st_dev != dir.device || opened.st_ino != dir.inode) {
+                ::close(fd);
+                continue;
+            }
+            DIR *stream = ::fdopendir(fd);
+            if (!stream) {
+                ::close(fd);
+                continue;
+            }
+
+            const std::string prefix = dir.path.back() == '/' ? dir.path : dir.path + "/";
+            chunk.clear();
+
+            while (dirent *ent = ::readdir(stream)) {
+                const char *name = ent->d_name;
+                if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+
+                bool isDir = ent->d_type == DT_DIR;
+                if (isDir || ent->d_type == DT_UNKNOWN) {
+                    // Excluded mount points are recognised by path: stat()ing
+                    // the root of a dead network mount would block the walk
+                    if (m_scope.excludesPath(prefix + name)) continue;
+                    struct stat st;
+                    if (::fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) continue;
+                    isDir = S_ISDIR(st.st_mode);
+                    if (isDir) {
+                        // Pruned subtrees are not reported either
+                        if (!m_scope.admits(st.st_dev, st.st_ino, dir.rootDevice)) continue;
+                        stack.push_back({prefix + name, dir.rootDevice, st.st_dev, st.st_ino, false});
+                    }
+                }
+
+                chunk.push_back({name, isDir});
+                if (chunk.size() == kChunkSize) {
+                    visit(dir.path, fd, chunk);
+                    chunk.clear();
+                    if (cancelled()) break;
+                }
+            }
+
+            if (!chunk.empty() && !cancelled()) visit(dir.path, fd, chunk);
+            ::closedir(stream);
+        }
+    }
+}
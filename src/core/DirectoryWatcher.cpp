@@ -0,0 +1,101 @@
+#include "core/DirectoryWatcher.h"
+#include <QSocketNotifier>
+#include <QTimer>
+#include <algorithm>
+#include <cerrno>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+DirectoryWatcher::DirectoryWatcher(QObject *parent) : QObject(parent), m_window(new QTimer(this)) {
+    // Fixed window from the first event on, so latency stays bounded even
+    // while events keep arriving
+    m_window->setSingleShot(true);
+    connect(m_window, &QTimer::timeout, this, &DirectoryWatcher::flush);
+}
+
+DirectoryWatcher::~DirectoryWatcher() {
+    stop();
+}
+
+bool DirectoryWatcher::watch(const QString &path) {
+    const int windowMs = path == m_path ? m_windowMs : kMinWindowMs;
+    stop();
+    m_path = path;
+    m_windowMs = windowMs;
+    m_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) return false;
+
+    const uint32_t mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY | IN_CLOSE_WRITE |
+                          IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_EXCL_UNLINK;
+    m_wd = ::inotify_add_watch(m_fd, path.toLocal8Bit().constData(), mask);
+    if (m_wd < 0) {
+        stop();
+        return false;
+    }
+
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &DirectoryWatcher::readEvents);
+    return true;
+}
+
+void DirectoryWatcher::stop() {
+    delete m_notifier;
+    m_notifier = nullptr;
+    if (m_fd >= 0) ::close(m_fd); // also drops the watch
+    m_fd = -1;
+    m_wd = -1;
+    m_window->stop();
+    m_pending.clear();
+    m_overflow = false;
+    m_windowMs = kMinWindowMs;
+}
+
+void DirectoryWatcher::readEvents() {
+    alignas(struct inotify_event) char buffer[64 * 1024];
+    for (;;) {
+        const ssize_t n = ::read(m_fd, buffer, sizeof(buffer));
+        if (n <= 0) break; // EAGAIN: drained
+
+        for (char *p = buffer; p < buffer + n;) {
+            const auto *event = reinterpret_cast<const struct inotify_event *>(p);
+            p += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & (IN_Q_OVERFLOW | IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                m_overflow = true;
+            } else if (!m_overflow && event->len > 0) {
+                m_pending.insert(QString::fromLocal8Bit(event->name));
+                // Past this point a relist is cheaper than per-name diffs
+                if (m_pending.size() > kMaxPending) {
+                    m_overflow = true;
+                    m_pending.clear();
+                }
+            }
+        }
+    }
+
+    if ((m_overflow || !m_pending.isEmpty()) && !m_window->isActive()) {
+        m_window->start(m_windowMs);
+    }
+}
+
+void DirectoryWatcher::flush() {
+    const int burst = m_pending.size();
+
+    if (m_overflow) {
+        m_overflow = false;
+        m_pending.clear();
+        m_windowMs = kMaxWindowMs;
+        emit overflowed();
+        return;
+    }
+    if (m_pending.isEmpty()) return;
+
+    const QStringList names(m_pending.begin(), m_pending.end());
+    m_pending.clear();
+
+    // Storms widen the next window; quiet periods shrink it back
+    if (burst > 256) m_windowMs = std::min(m_windowMs * 2, kMaxWindowMs);
+    else m_windowMs = std::max(m_windowMs / 2, kMinWindowMs);
+
+    emit changed(names);
+}
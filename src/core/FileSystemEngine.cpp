@@ -1,118 +1,206 @@
 #include "core/FileSystemEngine.h"
+#include "core/DirectoryWalker.h"
+#include "core/HashPipeline.h"
 #include <QFileInfo>
 #include <QDir>
 #include <iostream>
 #include <fstream>
+#include <chrono>
+#include <sys/stat.h>
 
 FileSystemEngine::FileSystemEngine(QObject *parent) : QObject(parent) {}
 
-std::future<QVector<FileInfo>> FileSystemEngine::listDirectory(const QString &path) {
-    return std::async(std::launch::async, [path, this]() {
-        QVector<FileInfo> results;
-        try {
-            fs::path p(path.toStdString());
-            if (fs::exists(p) && fs::is_directory(p)) {
-                for (const auto &entry : fs::directory_iterator(p)) {
-                    FileInfo info;
-                    info.name = QString::fromStdString(entry.path().filename().string());
-                    info.absolutePath = QString::fromStdString(fs::absolute(entry.path()).string());
-                    info.isDir = entry.is_directory();
-                    info.isHidden = info.name.startsWith(".");
-                    
-                    auto status = entry.status();
-                    info.permissions = getPermissionsString(status.permissions());
-                    
-                    if (!info.isDir) {
-                        info.size = fs::file_size(entry.path());
-                        info.type = "File";
-                    } else {
-                        info.size = 0;
-                        info.type = "Folder";
-                    }
-                    
-                    auto ftime = fs::last_write_time(entry.path());
-                    auto sctp = std::chrono::time_point_cast<std::chrono::system_clock::duration>(ftime - fs::file_time_type::clock::now() + std::chrono::system_clock::now());
-                    std::time_t cftime = std::chrono::system_clock::to_time_t(sctp);
-                    info.modified = QDateTime::fromSecsSinceEpoch(cftime);
-                    
-                    results.push_back(info);
-                }
-            }
-        } catch (const std::exception &e) {
-            // Error handling will be more robust in final version
+FileSystemEngine::~FileSystemEngine() {
+    cancelBatches();
+    waitForJobs();
+}
+
+void FileSystemEngine::listDirectoryAsync(const QString &path, ListingCallback callback) {
+    startJob([path, callback = std::move(callback)]() { callback(readDirectory(path)); }, ThreadPool::listing());
+}
+
+QVector<FileInfo> FileSystemEngine::readDirectory(const QString &path) {
+    QVector<FileInfo> results;
+    std::error_code ec;
+    for (auto it = fs::directory_iterator(path.toStdString(), ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+        FileInfo info;
+        // One unreadable entry must not cost the whole listing
+        if (statEntry(path, QString::fromStdString(it->path().filename().string()), &info)) {
+            results.push_back(info);
         }
-        return results;
-    });
+    }
+    return results;
+}
+
+bool FileSystemEngine::statEntry(const QString &dirPath, const QString &name, FileInfo *info) {
+    const QString absolutePath = QDir(dirPath).filePath(name);
+    const QByteArray local = absolutePath.toLocal8Bit();
+
+    // Follow symlinks like the listing always did; a dangling link is shown as itself
+    struct stat st;
+    if (::stat(local.constData(), &st) != 0 && ::lstat(local.constData(), &st) != 0) return false;
+
+    info->name = name;
+    info->absolutePath = absolutePath;
+    info->isDir = S_ISDIR(st.st_mode);
+    info->isHidden = name.startsWith(".");
+    info->permissions = getPermissionsString(static_cast<fs::perms>(st.st_mode & 0777));
+    info->size = info->isDir ? 0 : static_cast<long long>(st.st_size);
+    info->type = info->isDir ? "Folder" : "File";
+    info->modified = QDateTime::fromSecsSinceEpoch(st.st_mtim.tv_sec);
+    info->score = 0;
+    return true;
 }
 
 void FileSystemEngine::stopSearch() {
-    m_stopSearch = true;
+    m_search.cancel();
+}
+
+void FileSystemEngine::waitForSearch() {
+    m_search.wait();
+}
+
+bool FileSystemEngine::isCurrentSearch(SearchGeneration generation) const {
+    return m_search.isCurrent(generation);
+}
+
+void FileSystemEngine::setSearchScope(const SearchScopeOptions &options) {
+    std::lock_guard<std::mutex> lock(m_scopeMutex);
+    m_scopeOptions = options;
+}
+
+FileSystemEngine::SearchGeneration FileSystemEngine::searchAsync(const SearchQuery &query, std::shared_ptr<SearchResultStore> store,
+                                                                SearchCallback callback) {
+    SearchScopeOptions options;
+    {
+        std::lock_guard<std::mutex> lock(m_scopeMutex);
+        options = m_scopeOptions;
+    }
+    return m_search.start([this, query, options = std::move(options), store = std::move(store),
+                           callback = std::move(callback)](const SearchSession::Token &token) {
+        runSearch(query, options, *store, token, callback);
+    });
+}
+
+void FileSystemEngine::runSearch(const SearchQuery &query, SearchScopeOptions options, SearchResultStore &store,
+                                 const SearchSession::Token &token, const SearchCallback &callback) {
+    // path: filters are pushed down into the walk instead of tested per entry
+    if (!query.roots().empty()) options.roots = query.roots();
+
+    // Mounts are read and classified once per search; pruning during the
+    // walk is then a (device, inode) lookup per directory
+    const SearchScope scope(MountTable::load(), options);
+    const DirectoryWalker walker(scope);
+
+    EntryBatch batch;
+    std::vector<std::uint32_t> selection;
+    std::vector<SearchResultStore::NewHit> hits;
+
+    using Clock = std::chrono::steady_clock;
+    auto lastNotify = Clock::now();
+    bool full = false;
+
+    walker.walk([&](const std::string &dirPath, int dirFd, const std::vector<DirectoryWalker::Entry> &entries) {
+        batch.entries = &entries;
+        query.evaluate(batch, dirFd, selection);
+        if (selection.empty()) return;
+
+        const int prefixLength = QString::fromStdString(dirPath.back() == '/' ? dirPath : dirPath + "/").length();
+        hits.clear();
+        for (std::uint32_t row : selection) {
+            const auto &entry = entries[row];
+            const QString name = QString::fromStdString(entry.name);
+            hits.push_back({entry.name, entry.isDir, query.score(name, prefixLength + name.length())});
+        }
+
+        // Re-check right before publishing so a superseded walk adds nothing
+        if (token.cancelled()) return;
+        if (!store.append(dirPath, hits)) full = true;
+
+        const auto now = Clock::now();
+        if (now - lastNotify >= std::chrono::milliseconds(100)) {
+            lastNotify = now;
+            callback(token.generation(), false);
+        }
+    }, [&token, &full]() { return full || token.cancelled(); }); // a full store ends the walk early
+
+    if (!token.cancelled()) callback(token.generation(), true);
 }
 
-void FileSystemEngine::searchAsync(const QString &query, SearchCallback callback) {
-    m_stopSearch = false;
-    std::thread([this, query, callback]() {
+void FileSystemEngine::startJob(std::function<void()> job, ThreadPool &pool) {
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        ++m_jobsRunning;
+    }
+    pool.submit([this, job = std::move(job)]() {
         try {
-            fs::path root("/");
-            
-            // Directories to exclude to prevent hangs/loops/crashes
-            std::vector<std::string> excluded = {
-                "/proc", "/sys", "/dev", "/run", "/tmp", "/mnt", "/media", "/var/run", "/var/lock"
-            };
-
-            auto isExcluded = [&](const fs::path& p) {
-                std::string pathStr = p.string();
-                for (const auto& ex : excluded) {
-                    if (pathStr == ex || pathStr.rfind(ex + "/", 0) == 0) {
-                        return true;
-                    }
-                }
-                return false;
-            };
-
-            for (auto it = fs::recursive_directory_iterator(root, fs::directory_options::skip_permission_denied);
-                 it != fs::recursive_directory_iterator(); ++it) {
-                
-                if (m_stopSearch) break;
-
-                try {
-                    // Check exclusion before processing
-                    if (isExcluded(it->path())) {
-                        it.disable_recursion_pending();
-                        continue;
-                    }
-
-                    const auto& entry = *it;
-                    QString fileName = QString::fromStdString(entry.path().filename().string());
-                    
-                    if (fileName.contains(query, Qt::CaseInsensitive)) {
-                        FileInfo info;
-                        info.name = fileName;
-                        info.absolutePath = QString::fromStdString(fs::absolute(entry.path()).string());
-                        info.isDir = entry.is_directory();
-                        info.isHidden = info.name.startsWith(".");
-                        
-                        // Heuristic Scoring
-                        info.score = 0;
-                        // 1. Exact match (case insensitive): +100
-                        if (fileName.compare(query, Qt::CaseInsensitive) == 0) info.score += 100;
-                        // 2. Starts with: +50
-                        else if (fileName.startsWith(query, Qt::CaseInsensitive)) info.score += 50;
-                        // 3. Contains: +10 (already guaranteed)
-                        else info.score += 10;
-                        
-                        // 4. Penalty for depth/length: -1 per character in path (prefer shorter paths)
-                        info.score -= info.absolutePath.length();
-                        
-                        callback(info);
-                    }
-                } catch (...) {
-                    it.disable_recursion_pending();
-                }
-            }
+            job();
         } catch (...) {
         }
-    }).detach(); 
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        if (--m_jobsRunning == 0) m_jobsIdle.notify_all();
+    });
+}
+
+void FileSystemEngine::planBatchAsync(const QStringList &sources, const QString &destDir, BatchMode mode, BatchPlanCallback callback) {
+    std::vector<std::string> paths;
+    for (const auto &src : sources) paths.push_back(src.toStdString());
+    const quint64 epoch = m_batchEpoch.load();
+
+    startJob([this, paths = std::move(paths), dest = destDir.toStdString(), mode, epoch, callback = std::move(callback)]() {
+        auto plan = std::make_shared<BatchPlan>(BatchOperation::plan(paths, dest, mode));
+        if (m_batchEpoch.load() == epoch) callback(std::move(plan));
+    });
+}
+
+void FileSystemEngine::runBatchAsync(std::shared_ptr<const BatchPlan> plan, const BatchOptions &options,
+                                     BatchProgressCallback progress, BatchDoneCallback done) {
+    const quint64 epoch = m_batchEpoch.load();
+    startJob([this, plan = std::move(plan), options, epoch, progress = std::move(progress), done = std::move(done)]() {
+        BatchResult result = BatchOperation::run(*plan, options, progress, [this, epoch]() {
+            return m_batchEpoch.load(std::memory_order_relaxed) != epoch;
+        });
+        if (done) done(result);
+    });
+}
+
+void FileSystemEngine::verifyManifestAsync(const QString &dir, bool addNew, VerifyDoneCallback done) {
+    const quint64 epoch = m_batchEpoch.load();
+    startJob([this, dir = dir.toStdString(), addNew, epoch, done = std::move(done)]() {
+        HashPipeline pipeline;
+        VerifyReport report = ChecksumManifest::verify(dir, pipeline, addNew, [this, epoch]() {
+            return m_batchEpoch.load(std::memory_order_relaxed) != epoch;
+        });
+        if (done) done(report);
+    });
+}
+
+void FileSystemEngine::planSyncAsync(const QString &source, const QString &destination, SyncPlanCallback callback) {
+    const quint64 epoch = m_batchEpoch.load();
+    startJob([this, src = source.toStdString(), dest = destination.toStdString(), epoch, callback = std::move(callback)]() {
+        auto plan = std::make_shared<SyncPlan>(SyncOperation::plan(src, dest));
+        if (m_batchEpoch.load() == epoch) callback(std::move(plan));
+    });
+}
+
+void FileSystemEngine::runSyncAsync(std::shared_ptr<const SyncPlan> plan, const SyncOptions &options,
+                                    BatchProgressCallback progress, SyncDoneCallback done) {
+    const quint64 epoch = m_batchEpoch.load();
+    startJob([this, plan = std::move(plan), options, epoch, progress = std::move(progress), done = std::move(done)]() {
+        SyncResult result = SyncOperation::run(*plan, options, progress, [this, epoch]() {
+            return m_batchEpoch.load(std::memory_order_relaxed) != epoch;
+        });
+        if (done) done(result);
+    });
+}
+
+void FileSystemEngine::cancelBatches() {
+    m_batchEpoch.fetch_add(1);
+}
+
+void FileSystemEngine::waitForJobs() {
+    std::unique_lock<std::mutex> lock(m_jobMutex);
+    m_jobsIdle.wait(lock, [this]() { return m_jobsRunning == 0; });
 }
 
 QString FileSystemEngine::getPermissionsString(fs::perms p) {
@@ -0,0 +1,138 @@
+#include "core/HashPipeline.h"
+#include <QCryptographicHash>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+
+HashPipeline::HashPipeline() {
+    m_buffers.resize(kBufferCount);
+    for (auto &buffer : m_buffers) {
+        buffer.data = static_cast<char *>(std::aligned_alloc(4096, kBufferSize));
+        buffer.length = 0;
+        m_free.push_back(&buffer);
+    }
+    m_hasher = std::thread([this]() { hasherLoop(); });
+}
+
+HashPipeline::~HashPipeline() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_queued.notify_all();
+    m_hasher.join();
+    for (auto &buffer : m_buffers) std::free(buffer.data);
+}
+
+HashPipeline::Buffer *HashPipeline::acquire() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_freed.wait(lock, [this]() { return !m_free.empty(); });
+    Buffer *buffer = m_free.back();
+    m_free.pop_back();
+    return buffer;
+}
+
+void HashPipeline::submit(Buffer *buffer) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back({buffer, nullptr});
+    }
+    m_queued.notify_one();
+}
+
+void HashPipeline::release(Buffer *buffer) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free.push_back(buffer);
+    }
+    m_freed.notify_one();
+}
+
+std::string HashPipeline::finish() {
+    std::promise<std::string> digest;
+    std::future<std::string> result = digest.get_future();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back({nullptr, &digest});
+    }
+    m_queued.notify_one();
+    return result.get();
+}
+
+void HashPipeline::hasherLoop() {
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    for (;;) {
+        Message message;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_queued.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+            if (m_queue.empty()) return;
+            message = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        if (!message.buffer) {
+            message.digest->set_value(hash.result().toHex().toStdString());
+            hash.reset();
+            continue;
+        }
+        hash.addData(QByteArrayView(message.buffer->data, static_cast<qsizetype>(message.buffer->length)));
+        release(message.buffer);
+    }
+}
+
+bool HashPipeline::hashFile(const std::string &path, bool bypassCache, std::string *digest) {
+    auto openCached = [&]() {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        // Callers flush what they wrote first, so this forces a re-read from disk
+        if (fd >= 0 && bypassCache) ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        return fd;
+    };
+
+    bool direct = bypassCache;
+    int fd = direct ? ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT) : -1;
+    if (fd < 0) {
+        direct = false;
+        fd = openCached();
+    }
+    if (fd < 0) return false;
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    bool ok = true;
+    for (;;) {
+        Buffer *buffer = acquire();
+        ssize_t n = ::read(fd, buffer->data, kBufferSize);
+        if (n < 0 && errno == EINTR) {
+            release(buffer);
+            continue;
+        }
+        if (n < 0 && direct && errno == EINVAL) {
+            // Some filesystems accept O_DIRECT at open time but refuse the reads
+            release(buffer);
+            const off_t offset = ::lseek(fd, 0, SEEK_CUR);
+            ::close(fd);
+            direct = false;
+            fd = openCached();
+            if (fd < 0) {
+                finish();
+                return false;
+            }
+            ::lseek(fd, offset, SEEK_SET);
+            continue;
+        }
+        if (n <= 0) {
+            release(buffer);
+            ok = n == 0;
+            break;
+        }
+        buffer->length = static_cast<std::size_t>(n);
+        submit(buffer);
+    }
+    ::close(fd);
+
+    // Always close the stream so the next file starts from a fresh hash
+    std::string result = finish();
+    if (ok && digest) *digest = std::move(result);
+    return ok;
+}
@@ -0,0 +1,85 @@
+#include "core/MountTable.h"
+#include <fstream>
+#include <sstream>
+#include <sys/sysmacros.h>
+#include <unordered_set>
+
+// mountinfo escapes space, tab, newline and backslash as \ooo
+static std::string unescapeOctal(const std::string &field) {
+    std::string out;
+    out.reserve(field.size());
+    for (std::size_t i = 0; i < field.size(); ++i) {
+        if (field[i] == '\\' && i + 3 < field.size()) {
+            const char a = field[i + 1], b = field[i + 2], c = field[i + 3];
+            if (a >= '0' && a <= '7' && b >= '0' && b <= '7' && c >= '0' && c <= '7') {
+                out += static_cast<char>((a - '0') * 64 + (b - '0') * 8 + (c - '0'));
+                i += 3;
+                continue;
+            }
+        }
+        out += field[i];
+    }
+    return out;
+}
+
+MountTable MountTable::load(const std::string &path) {
+    std::ifstream in(path);
+    return parse(in);
+}
+
+MountTable MountTable::parse(std::istream &in) {
+    MountTable table;
+    std::string line;
+    while (std::getline(in, line)) {
+        // 36 35 98:0 /mnt1 /mnt/parent rw,noatime master:1 - ext3 /dev/root rw
+        std::istringstream fields(line);
+        std::string mountId, parentId, majorMinor, root, mountPoint, options;
+        if (!(fields >> mountId >> parentId >> majorMinor >> root >> mountPoint >> options)) continue;
+
+        // Skip optional fields up to the "-" separator
+        std::string token;
+        while (fields >> token && token != "-") {}
+        std::string fsType;
+        if (token != "-" || !(fields >> fsType)) continue;
+
+        const auto colon = majorMinor.find(':');
+        if (colon == std::string::npos) continue;
+
+        MountEntry entry;
+        try {
+            entry.device = makedev(std::stoul(majorMinor.substr(0, colon)), std::stoul(majorMinor.substr(colon + 1)));
+        } catch (...) {
+            continue;
+        }
+        entry.mountPoint = unescapeOctal(mountPoint);
+        entry.fsType = fsType;
+        entry.kind = classify(fsType);
+        table.m_entries.push_back(std::move(entry));
+    }
+    return table;
+}
+
+MountClass MountTable::classify(const std::string &fsType) {
+    static const std::unordered_set<std::string> network = {
+        "nfs", "nfs4", "cifs", "smb3", "smbfs", "ncpfs", "ceph", "glusterfs",
+        "9p", "afs", "coda", "lustre", "gpfs", "beegfs", "davfs", "orangefs"
+    };
+    static const std::unordered_set<std::string> overlay = {
+        "overlay", "overlayfs", "aufs", "unionfs"
+    };
+    static const std::unordered_set<std::string> virtualFs = {
+        "proc", "sysfs", "devtmpfs", "devpts", "tmpfs", "ramfs", "cgroup", "cgroup2",
+        "securityfs", "debugfs", "tracefs", "pstore", "bpf", "mqueue", "hugetlbfs",
+        "configfs", "fusectl", "autofs", "binfmt_misc", "efivarfs", "rpc_pipefs",
+        "nsfs", "selinuxfs"
+    };
+
+    if (fsType == "fuse" || fsType == "fuseblk" || fsType.rfind("fuse.", 0) == 0) {
+        // fuseblk is ntfs-3g/exfat on a local block device
+        return fsType == "fuseblk" ? MountClass::Local : MountClass::Fuse;
+    }
+    if (network.count(fsType)) return MountClass::Network;
+    if (overlay.count(fsType)) return MountClass::Overlay;
+    if (virtualFs.count(fsType)) return MountClass::Virtual;
+    return MountClass::Local;
+}
@@ -0,0 +1,26 @@
+#include "core/PathArena.h"
+#include <algorithm>
+
+PathArena::NodeId PathArena::add(NodeId parent, std::string_view name, bool isDir) {
+    const Node node{m_names.size(), parent, static_cast<std::uint32_t>(name.size()) | (isDir ? kDirFlag : 0u)};
+    m_names.append(name);
+    m_nodes.push_back(node);
+    return static_cast<NodeId>(m_nodes.size() - 1);
+}
+
+std::string PathArena::path(NodeId node) const {
+    std::vector<std::string_view> parts;
+    std::size_t length = 0;
+    for (NodeId n = node; n != kNone; n = m_nodes[n].parent) {
+        parts.push_back(name(n));
+        length += parts.back().size() + 1;
+    }
+
+    std::string out;
+    out.reserve(length);
+    for (auto it = parts.rbegin(); it != parts.rend(); ++it) {
+        if (!out.empty() && out.back() != '/') out += '/';
+        out.append(*it);
+    }
+    return out;
+}
@@ -0,0 +1,288 @@
+#include "core/SearchQuery.h"
+#include <QDate>
+#include <QDateTime>
+#include <QDir>
+#include <QRegularExpression>
+#include <QStringList>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <numeric>
+#include <sys/stat.h>
+
+// Keeps the rows for which keep(row) holds. Branch-free so the loop body is
+// a load, a compare and a conditional increment.
+template <typename Keep>
+static void compact(std::vector<std::uint32_t> &selection, Keep keep) {
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < selection.size(); ++i) {
+        const std::uint32_t row = selection[i];
+        selection[kept] = row;
+        kept += keep(row) ? 1 : 0;
+    }
+    selection.resize(kept);
+}
+
+enum class Compare { Less, LessEqual, Greater, GreaterEqual, Equal };
+
+template <typename T>
+static bool compareWith(Compare op, T value, T bound) {
+    switch (op) {
+    case Compare::Less: return value < bound;
+    case Compare::LessEqual: return value <= bound;
+    case Compare::Greater: return value > bound;
+    case Compare::GreaterEqual: return value >= bound;
+    case Compare::Equal: return value == bound;
+    }
+    return false;
+}
+
+static Compare parseCompare(const QString &op) {
+    if (op == "<") return Compare::Less;
+    if (op == "<=") return Compare::LessEqual;
+    if (op == ">") return Compare::Greater;
+    if (op == ">=") return Compare::GreaterEqual;
+    return Compare::Equal;
+}
+
+// Numeric filter over one column, with the operator hoisted out of the loop
+template <typename T>
+static void compactColumn(std::vector<std::uint32_t> &selection, const std::vector<T> &column, Compare op, T bound) {
+    switch (op) {
+    case Compare::Less: compact(selection, [&](std::uint32_t r) { return column[r] < bound; }); break;
+    case Compare::LessEqual: compact(selection, [&](std::uint32_t r) { return column[r] <= bound; }); break;
+    case Compare::Greater: compact(selection, [&](std::uint32_t r) { return column[r] > bound; }); break;
+    case Compare::GreaterEqual: compact(selection, [&](std::uint32_t r) { return column[r] >= bound; }); break;
+    case Compare::Equal: compact(selection, [&](std::uint32_t r) { return column[r] == bound; }); break;
+    }
+}
+
+static bool isAscii(const std::string &s) {
+    return std::all_of(s.begin(), s.end(), [](unsigned char c) { return c < 0x80; });
+}
+
+static char asciiLower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+static QStringList tokenize(const QString &text) {
+    QStringList tokens;
+    QString current;
+    bool quoted = false;
+    for (QChar c : text) {
+        if (c == '"') {
+            quoted = !quoted;
+        } else if (c.isSpace() && !quoted) {
+            if (!current.isEmpty()) tokens << current;
+            current.clear();
+        } else {
+            current += c;
+        }
+    }
+    if (!current.isEmpty()) tokens << current;
+    return tokens;
+}
+
+void SearchQuery::addPredicate(Stage stage, double cost, double selectivity,
+                               std::function<void(const EntryBatch &, std::vector<std::uint32_t> &)> filter) {
+    m_predicates.push_back({stage, cost / std::max(selectivity, 0.01), std::move(filter)});
+}
+
+SearchQuery SearchQuery::parse(const QString &text, QString *error) {
+    SearchQuery query;
+    auto fail = [&](const QString &message) {
+        if (error) *error = message;
+        return SearchQuery();
+    };
+    if (error) error->clear();
+
+    static const QRegularExpression sizeRe(R"(^(<=|>=|<|>|=)?(\d+(?:\.\d+)?)([kmgt]?)(?:i?b)?$)",
+                                           QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression ageRe(R"(^(<=|>=|<|>|=)?(\d+(?:\.\d+)?)([smhdw])$)",
+                                          QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression dateRe(R"(^(<=|>=|<|>|=)?(\d{4}-\d{2}-\d{2})$)");
+    static const QRegularExpression modeRe(R"(^[0-7]{3,4}$)");
+
+    for (const QString &token : tokenize(text)) {
+        const int colon = token.indexOf(':');
+        const QString key = colon > 0 ? token.left(colon).toLower() : QString();
+        const QString value = colon > 0 ? token.mid(colon + 1) : token;
+
+        if (key == "ext") {
+            const bool first = query.m_extensions.empty();
+            for (const QString &ext : value.split(',', Qt::SkipEmptyParts)) {
+                QString clean = ext.startsWith('.') ? ext.mid(1) : ext;
+                std::string lower = clean.toLower().toStdString();
+                query.m_extensions.emplace(lower, static_cast<std::uint32_t>(query.m_extensions.size() + 1));
+            }
+            if (query.m_extensions.empty()) return fail("ext: needs at least one extension");
+            // One predicate for the whole list; the column holds 0 for anything outside it
+            if (first) query.addPredicate(Stage::Entry, 2, 0.9, [](const EntryBatch &b, std::vector<std::uint32_t> &sel) {
+                compact(sel, [&](std::uint32_t r) { return b.extId[r] != 0; });
+            });
+        } else if (key == "size") {
+            auto m = sizeRe.match(value);
+            if (!m.hasMatch()) return fail("Bad size filter: " + value);
+            static const QString units = "kmgt";
+            const QString suffix = m.captured(3).toLower();
+            const int unit = suffix.isEmpty() ? 0 : units.indexOf(suffix) + 1;
+            const auto bound = static_cast<std::int64_t>(m.captured(2).toDouble() * std::pow(1024.0, unit));
+            const Compare op = parseCompare(m.captured(1));
+            // Lower bounds on size are usually what makes a query selective
+            const bool selective = (op == Compare::Greater || op == Compare::GreaterEqual) && bound >= (1 << 20);
+            const double selectivity = op == Compare::Equal ? 0.99 : (selective ? 0.95 : 0.5);
+            query.addPredicate(Stage::Metadata, 1, selectivity, [op, bound](const EntryBatch &b, std::vector<std::uint32_t> &sel) {
+                compactColumn(sel, b.size, op, bound);
+            });
+        } else if (key == "mtime") {
+            std::int64_t bound;
+            Compare op;
+            if (auto m = ageRe.match(value); m.hasMatch()) {
+                static const QString unitChars = "smhdw";
+                static const std::int64_t unitSecs[] = {1, 60, 3600, 86400, 7 * 86400};
+                const auto age = static_cast<std::int64_t>(
+                    m.captured(2).toDouble() * unitSecs[unitChars.indexOf(m.captured(3).toLower())]);
+                bound = QDateTime::currentSecsSinceEpoch() - age;
+                // The operator reads as "age <op> value": younger means a later mtime
+                const QString ageOp = m.captured(1).isEmpty() ? "<" : m.captured(1);
+                if (ageOp == "=") return fail("mtime: durations take < or >, e.g. mtime:<7d");
+                op = ageOp == "<" ? Compare::Greater : ageOp == "<=" ? Compare::GreaterEqual
+                   : ageOp == ">" ? Compare::Less : Compare::LessEqual;
+            } else if (auto d = dateRe.match(value); d.hasMatch()) {
+                const QDate date = QDate::fromString(d.captured(2), Qt::ISODate);
+                if (!date.isValid()) return fail("Bad date: " + d.captured(2));
+                const std::int64_t dayStart = date.startOfDay().toSecsSinceEpoch();
+                const QString dateOp = d.captured(1);
+                if (dateOp.isEmpty() || dateOp == "=") {
+                    query.addPredicate(Stage::Metadata, 1, 0.95, [dayStart](const EntryBatch &b, std::vector<std::uint32_t> &sel) {
+                        compact(sel, [&](std::uint32_t r) { return b.mtime[r] >= dayStart && b.mtime[r] < dayStart + 86400; });
+                    });
+                    continue;
+                }
+                // "after a date" means after the whole day
+                op = parseCompare(dateOp);
+                bound = (op == Compare::Greater || op == Compare::LessEqual) ? dayStart + 86399 : dayStart;
+            } else {
+                return fail("Bad mtime filter: " + value);
+            }
+            query.addPredicate(Stage::Metadata, 1, 0.8, [op, bound](const EntryBatch &b, std::vector<std::uint32_t> &sel) {
+                compactColumn(sel, b.mtime, op, bound);
+            });
+        } else if (key == "type") {
+            const QString t = value.toLower();
+            bool wantDir;
+            if (t == "d" || t == "dir" || t == "directory") wantDir = true;
+            else if (t == "f" || t == "file") wantDir = false;
+            else return fail("type: takes f or d");
+            query.addPredicate(Stage::Entry, 1, 0.5, [wantDir](const EntryBatch &b, std::vector<std::uint32_t> &sel) {
+                const auto &entries = *b.entries;
+                compact(sel, [&](std::uint32_t r) { return entries[r].isDir == wantDir; });
+            });
+        } else if (key == "mode") {
+            if (!modeRe.match(value).hasMatch()) return fail("mode: takes octal permission bits, e.g. mode:644");
+            const std::uint32_t bits = value.toUInt(nullptr, 8);
+            query.addPredicate(Stage::Metadata, 1, 0.7, [bits](const EntryBatch &b, std::vector<std::uint32_t> &sel) {
+                compact(sel, [&](std::uint32_t r) { return (b.mode[r] & 07777) == bits; });
+            });
+        } else if (key == "path") {
+            QString dir = value.startsWith('~') ? QDir::homePath() + value.mid(1) : value;
+            if (!QDir::isAbsolutePath(dir)) return fail("path: must be absolute");
+            query.m_roots.push_back(QDir::cleanPath(dir).toStdString());
+        } else {
+            // Plain words (and unknown keys such as "a:b") match the file name
+            const QString needle = key == "name" ? value : token;
+            if (needle.isEmpty()) continue;
+            query.m_nameTerms.push_back(needle);
+
+            const std::string utf8 = needle.toStdString();
+            std::string lowered;
+            const bool asciiNeedle = isAscii(utf8);
+            if (asciiNeedle) std::transform(utf8.begin(), utf8.end(), std::back_inserter(lowered), asciiLower);
+
+            query.addPredicate(Stage::Entry, 8, 0.95, [needle, lowered, asciiNeedle](const EntryBatch &b, std::vector<std::uint32_t> &sel) {
+                const auto &entries = *b.entries;
+                compact(sel, [&](std::uint32_t r) {
+                    const std::string &name = entries[r].name;
+                    // ASCII names are matched in place; only the rest pay for a QString
+                    if (asciiNeedle && isAscii(name)) {
+                        return std::search(name.begin(), name.end(), lowered.begin(), lowered.end(),
+                                           [](char a, char n) { return asciiLower(a) == n; }) != name.end();
+                    }
+                    return QString::fromStdString(name).contains(needle, Qt::CaseInsensitive);
+                });
+            });
+        }
+    }
+
+    std::stable_sort(query.m_predicates.begin(), query.m_predicates.end(), [](const Predicate &a, const Predicate &b) {
+        if (a.stage != b.stage) return a.stage == Stage::Entry;
+        return a.rank < b.rank;
+    });
+    return query;
+}
+
+void SearchQuery::fillExtensions(EntryBatch &batch, const std::vector<std::uint32_t> &selection) const {
+    const auto &entries = *batch.entries;
+    batch.extId.resize(entries.size());
+    std::string ext;
+    for (std::uint32_t row : selection) {
+        const std::string &name = entries[row].name;
+        const auto dot = name.rfind('.');
+        // Dotfiles such as ".bashrc" have no extension
+        if (dot == std::string::npos || dot == 0 || dot + 1 == name.size()) {
+            batch.extId[row] = 0;
+            continue;
+        }
+        ext.assign(name, dot + 1, std::string::npos);
+        std::transform(ext.begin(), ext.end(), ext.begin(), asciiLower);
+        auto it = m_extensions.find(ext);
+        batch.extId[row] = it == m_extensions.end() ? 0 : it->second;
+    }
+}
+
+void SearchQuery::fillMetadata(EntryBatch &batch, int dirFd, std::vector<std::uint32_t> &selection) {
+    const auto &entries = *batch.entries;
+    batch.size.resize(entries.size());
+    batch.mtime.resize(entries.size());
+    batch.mode.resize(entries.size());
+    compact(selection, [&](std::uint32_t row) {
+        struct stat st;
+        if (::fstatat(dirFd, entries[row].name.c_str(), &st, AT_SYMLINK_NOFOLLOW) != 0) return false;
+        batch.size[row] = st.st_size;
+        batch.mtime[row] = st.st_mtim.tv_sec;
+        batch.mode[row] = st.st_mode;
+        return true;
+    });
+}
+
+void SearchQuery::evaluate(EntryBatch &batch, int dirFd, std::vector<std::uint32_t> &selection) const {
+    selection.resize(batch.rows());
+    std::iota(selection.begin(), selection.end(), 0u);
+    if (!m_extensions.empty()) fillExtensions(batch, selection);
+
+    bool haveMetadata = false;
+    for (const auto &predicate : m_predicates) {
+        if (selection.empty()) return;
+        if (predicate.stage == Stage::Metadata && !haveMetadata) {
+            fillMetadata(batch, dirFd, selection);
+            haveMetadata = true;
+            if (selection.empty()) return;
+        }
+        predicate.filter(batch, selection);
+    }
+}
+
+int SearchQuery::score(const QString &fileName, int pathLength) const {
+    int score = 0;
+    if (m_nameTerms.empty()) score += 10;
+    for (const QString &term : m_nameTerms) {
+        // 1. Exact match (case insensitive): +100
+        if (fileName.compare(term, Qt::CaseInsensitive) == 0) score += 100;
+        // 2. Starts with: +50
+        else if (fileName.startsWith(term, Qt::CaseInsensitive)) score += 50;
+        // 3. Contains: +10 (already guaranteed)
+        else score += 10;
+    }
+    // 4. Penalty for depth/length: -1 per character in path (prefer shorter paths)
+    return score - pathLength;
+}
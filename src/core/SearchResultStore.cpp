@@ -0,0 +1,74 @@
+#include "core/SearchResultStore.h"
+#include <algorithm>
+
+PathArena::NodeId SearchResultStore::directoryNode(const std::string &dirPath) {
+    if (m_root == PathArena::kNone) m_root = m_arena.add(PathArena::kNone, "/", true);
+
+    std::size_t depth = 0;
+    std::size_t pos = 0;
+    PathArena::NodeId node = m_root;
+    while (pos < dirPath.size()) {
+        if (dirPath[pos] == '/') {
+            ++pos;
+            continue;
+        }
+        std::size_t end = dirPath.find('/', pos);
+        if (end == std::string::npos) end = dirPath.size();
+        std::string_view component(dirPath.data() + pos, end - pos);
+
+        if (depth < m_chain.size() && m_chain[depth].first == component) {
+            node = m_chain[depth].second;
+        } else {
+            m_chain.resize(depth);
+            node = m_arena.add(node, component, true);
+            m_chain.emplace_back(std::string(component), node);
+        }
+        ++depth;
+        pos = end;
+    }
+    m_chain.resize(depth);
+    return node;
+}
+
+bool SearchResultStore::append(const std::string &dirPath, const std::vector<NewHit> &hits) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (hits.empty()) return !m_truncated;
+    const std::size_t room = m_maxHits - m_hits.size();
+    if (room == 0) {
+        m_truncated = true;
+        return false;
+    }
+    const PathArena::NodeId dir = directoryNode(dirPath);
+    const std::size_t take = std::min(room, hits.size());
+    for (std::size_t i = 0; i < take; ++i) {
+        m_hits.push_back({m_arena.add(dir, hits[i].name, hits[i].isDir), hits[i].score});
+    }
+    if (take < hits.size()) m_truncated = true;
+    return !m_truncated;
+}
+
+std::size_t SearchResultStore::hitCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_hits.size();
+}
+
+bool SearchResultStore::isTruncated() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_truncated;
+}
+
+void SearchResultStore::scores(std::size_t from, std::size_t to, std::vector<std::int32_t> &out) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    out.clear();
+    for (std::size_t i = from; i < to && i < m_hits.size(); ++i) out.push_back(m_hits[i].score);
+}
+
+std::string SearchResultStore::path(std::size_t hit) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_arena.path(m_hits[hit].node);
+}
+
+bool SearchResultStore::isDir(std::size_t hit) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_arena.isDir(m_hits[hit].node);
+}
@@ -0,0 +1,63 @@
+#include "core/SearchScope.h"
+#include <sys/stat.h>
+#include <unordered_map>
+
+SearchScope::SearchScope(const MountTable &mounts, const SearchScopeOptions &options)
+    : m_oneFileSystem(options.oneFileSystem) {
+    struct stat st;
+
+    auto excludedByClass = [&options](MountClass kind) {
+        switch (kind) {
+        case MountClass::Local: return false;
+        case MountClass::Network: return !options.includeNetwork;
+        case MountClass::Fuse: return !options.includeFuse;
+        case MountClass::Overlay: return !options.includeOverlay;
+        case MountClass::Virtual: return !options.includeVirtual;
+        }
+        return false;
+    };
+
+    // The last mount listed at a path is the one visible there. Known by
+    // path, these are never stat()ed: not here and not by the walker.
+    std::unordered_map<std::string, bool> visible;
+    for (const auto &mount : mounts.entries()) visible[mount.mountPoint] = excludedByClass(mount.kind);
+    for (const auto &entry : visible) {
+        if (entry.second) m_excludedPaths.insert(entry.first);
+    }
+
+    for (const auto &path : options.excludedPaths) {
+        m_excludedPaths.insert(path);
+        if (visible.count(path) && visible[path]) continue;
+        if (::stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+            m_excludedDirs.insert({st.st_dev, st.st_ino});
+        }
+    }
+
+    std::unordered_set<dev_t> rootDevices;
+    for (const auto &path : options.roots) {
+        if (::stat(path.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) continue;
+        if (m_excludedDirs.count({st.st_dev, st.st_ino})) continue;
+        if (!m_rootDirs.insert({st.st_dev, st.st_ino}).second) continue;
+        m_roots.push_back({path, st.st_dev, st.st_ino});
+        rootDevices.insert(st.st_dev);
+        // A root is searched even if its path would otherwise be excluded
+        m_excludedPaths.erase(path);
+    }
+
+    for (const auto &mount : mounts.entries()) {
+        // A mount the user explicitly searches from is never excluded by
+        // class (e.g. "/" itself on overlay inside a container)
+        if (rootDevices.count(mount.device)) {
+            m_excludedPaths.erase(mount.mountPoint);
+            continue;
+        }
+        if (excludedByClass(mount.kind)) m_excludedDevices.insert(mount.device);
+    }
+}
+
+bool SearchScope::admits(dev_t device, ino_t inode, dev_t rootDevice) const {
+    if (m_oneFileSystem && device != rootDevice) return false;
+    if (m_excludedDevices.count(device)) return false;
+    const DevIno key{device, inode};
+    return !m_excludedDirs.count(key) && !m_rootDirs.count(key);
+}
@@ -0,0 +1,39 @@
+#include "core/SearchSession.h"
+
+SearchSession::SearchSession(ThreadPool &pool) : m_pool(pool) {}
+
+SearchSession::~SearchSession() {
+    cancel();
+    wait();
+}
+
+SearchSession::Generation SearchSession::start(Job job) {
+    Generation generation = m_current.fetch_add(1, std::memory_order_acq_rel) + 1;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_running;
+    }
+
+    m_pool.submit([this, job = std::move(job), generation]() {
+        Token token(&m_current, generation);
+        // A walk superseded while still queued never touches the filesystem
+        if (!token.cancelled()) {
+            try {
+                job(token);
+            } catch (...) {
+            }
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_running == 0) m_idle.notify_all();
+    });
+    return generation;
+}
+
+void SearchSession::cancel() {
+    m_current.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void SearchSession::wait() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this]() { return m_running == 0; });
+}
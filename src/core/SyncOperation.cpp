@@ -0,0 +1,377 @@
+#include "core/SyncOperation.h"
+#include "core/ThreadPool.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <mutex>
+#include <unordered_set>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+static bool contains(const fs::path &outer, const fs::path &inner) {
+    std::error_code ec;
+    const fs::path o = fs::weakly_canonical(outer, ec);
+    const fs::path i = fs::weakly_canonical(inner, ec);
+    return std::mismatch(o.begin(), o.end(), i.begin(), i.end()).first == o.end();
+}
+
+// Pre-order walk below root. Unreadable folders are recorded in errors and
+// the walk carries on with the rest of the tree; visit() returns whether to
+// descend into the entry.
+static void walkTree(const fs::path &root, std::vector<std::string> &errors,
+                     const std::function<bool(const fs::path &, const fs::path &, const struct stat &)> &visit) {
+    std::vector<fs::path> pending{fs::path()};
+    while (!pending.empty()) {
+        const fs::path rel = std::move(pending.back());
+        pending.pop_back();
+        const fs::path dir = rel.empty() ? root : root / rel;
+
+        std::error_code ec;
+        for (auto it = fs::directory_iterator(dir, ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+            struct stat st;
+            if (::lstat(it->path().c_str(), &st) != 0) {
+                if (errno != ENOENT) errors.push_back(it->path().string() + ": " + std::strerror(errno));
+                continue; // ENOENT: removed while walking
+            }
+            const fs::path childRel = rel / it->path().filename();
+            if (visit(it->path(), childRel, st) && S_ISDIR(st.st_mode)) pending.push_back(childRel);
+        }
+        if (ec) errors.push_back(dir.string() + ": " + ec.message());
+    }
+}
+
+SyncPlan SyncOperation::plan(const std::string &source, const std::string &destination) {
+    SyncPlan plan;
+    fs::path src = fs::path(source).lexically_normal();
+    fs::path dst = fs::path(destination).lexically_normal();
+    if (!src.has_filename() && src != src.root_path()) src = src.parent_path();
+    if (!dst.has_filename() && dst != dst.root_path()) dst = dst.parent_path();
+    plan.source = src.string();
+    plan.destination = dst.string();
+
+    struct stat st;
+    if (::stat(plan.source.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+        plan.errors.push_back(plan.source + ": not a directory");
+        return plan;
+    }
+    if (::stat(plan.destination.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+        plan.errors.push_back(plan.destination + ": not a directory");
+        return plan;
+    }
+    if (contains(src, dst) || contains(dst, src)) {
+        plan.errors.push_back("cannot sync a folder with itself or one of its subfolders");
+        return plan;
+    }
+
+    std::vector<SyncItem> dirs, files, deletes;
+    auto countReplace = [&plan](const SyncItem &item) {
+        if (!item.replace) return;
+        ++plan.deletes;
+        ++plan.replaces;
+    };
+    walkTree(src, plan.errors, [&](const fs::path &path, const fs::path &rel, const struct stat &from) {
+        struct stat to;
+        const bool exists = ::lstat((dst / rel).c_str(), &to) == 0;
+
+        SyncItem item;
+        item.relative = rel.string();
+        if (S_ISDIR(from.st_mode)) {
+            if (exists && S_ISDIR(to.st_mode)) return true;
+            item.action = SyncItem::CreateDir;
+            item.replace = exists;
+            countReplace(item);
+            ++plan.creates;
+            dirs.push_back(std::move(item));
+            return true;
+        }
+        if (S_ISLNK(from.st_mode)) {
+            std::error_code linkEc;
+            if (exists && S_ISLNK(to.st_mode) && fs::read_symlink(path, linkEc) == fs::read_symlink(dst / rel, linkEc)) {
+                ++plan.unchanged;
+                return false;
+            }
+            // Re-pointing an existing link is an update, not a replacement
+            item.action = SyncItem::Symlink;
+            item.replace = exists && !S_ISLNK(to.st_mode);
+            countReplace(item);
+            ++(exists ? plan.updates : plan.creates);
+            files.push_back(std::move(item));
+        } else if (S_ISREG(from.st_mode)) {
+            item.size = static_cast<std::uint64_t>(from.st_size);
+            const bool regular = exists && S_ISREG(to.st_mode);
+            // Whole seconds, like rsync: some destinations cannot store finer mtimes
+            if (regular && to.st_size == from.st_size && to.st_mtim.tv_sec == from.st_mtim.tv_sec) {
+                ++plan.unchanged;
+                plan.unchangedBytes += item.size;
+                return false;
+            }
+            if (regular) {
+                item.action = SyncItem::Update;
+                ++plan.updates;
+                plan.updateBytes += item.size;
+            } else {
+                item.action = SyncItem::Create;
+                item.replace = exists;
+                countReplace(item);
+                ++plan.creates;
+                plan.createBytes += item.size;
+            }
+            files.push_back(std::move(item));
+        } else {
+            plan.errors.push_back(path.string() + ": not a regular file, directory or symlink");
+        }
+        return false;
+    });
+
+    walkTree(dst, plan.errors, [&](const fs::path &, const fs::path &rel, const struct stat &) {
+        struct stat from;
+        if (::lstat((src / rel).c_str(), &from) == 0) {
+            // A folder replaced by a file goes away with the replace, not item by item
+            return S_ISDIR(from.st_mode);
+        }
+        // Only what is provably gone from the source is deleted; an unreadable
+        // source folder must not look empty
+        if (errno != ENOENT) {
+            plan.errors.push_back((src / rel).string() + ": " + std::strerror(errno));
+            return false;
+        }
+        SyncItem item;
+        item.action = SyncItem::Delete;
+        item.relative = rel.string();
+        deletes.push_back(std::move(item));
+        ++plan.deletes;
+        return false;
+    });
+
+    plan.items.reserve(deletes.size() + dirs.size() + files.size());
+    for (auto *group : {&deletes, &dirs, &files}) {
+        std::move(group->begin(), group->end(), std::back_inserter(plan.items));
+    }
+    return plan;
+}
+
+static ssize_t preadFull(int fd, char *buffer, std::size_t length, off_t offset) {
+    std::size_t done = 0;
+    while (done < length) {
+        const ssize_t n = ::pread(fd, buffer + done, length - done, offset + static_cast<off_t>(done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return -1;
+        if (n == 0) break;
+        done += static_cast<std::size_t>(n);
+    }
+    return static_cast<ssize_t>(done);
+}
+
+static bool pwriteFull(int fd, const char *buffer, std::size_t length, off_t offset) {
+    std::size_t done = 0;
+    while (done < length) {
+        const ssize_t n = ::pwrite(fd, buffer + done, length - done, offset + static_cast<off_t>(done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+// Both trees are local, so blocks are compared at the same offsets directly;
+// only blocks that differ are written back, and the file is cut or grown to
+// the source length
+static bool patchBlocks(int in, int out, std::uint64_t *written, std::uint64_t *matched,
+                        const std::function<void(std::uint64_t)> &advance, const BatchOperation::CancelCheck &cancelled) {
+    struct stat from, to;
+    if (::fstat(in, &from) != 0 || ::fstat(out, &to) != 0) return false;
+    const off_t size = from.st_size;
+    std::vector<char> source(SyncOperation::kBlockSize), target(SyncOperation::kBlockSize);
+
+    off_t offset = 0;
+    while (offset < size) {
+        if (cancelled()) return false;
+        const std::size_t want = static_cast<std::size_t>(std::min<off_t>(SyncOperation::kBlockSize, size - offset));
+        const ssize_t n = preadFull(in, source.data(), want, offset);
+        if (n < 0) return false;
+        if (n == 0) break; // source shrank since it was stat'ed
+
+        const ssize_t have = offset < to.st_size ? preadFull(out, target.data(), static_cast<std::size_t>(n), offset) : 0;
+        if (have < 0) return false;
+        if (have == n && std::memcmp(source.data(), target.data(), static_cast<std::size_t>(n)) == 0) {
+            *matched += static_cast<std::uint64_t>(n);
+        } else {
+            if (!pwriteFull(out, source.data(), static_cast<std::size_t>(n), offset)) return false;
+            *written += static_cast<std::uint64_t>(n);
+        }
+        offset += n;
+        advance(static_cast<std::uint64_t>(n));
+    }
+    return to.st_size == offset || ::ftruncate(out, offset) == 0;
+}
+
+SyncResult SyncOperation::run(const SyncPlan &plan, const SyncOptions &options,
+                              const BatchOperation::ProgressCallback &progress, const BatchOperation::CancelCheck &cancelled) {
+    const fs::path src(plan.source);
+    const fs::path dst(plan.destination);
+
+    SyncResult result;
+    BatchProgress state;
+    state.bytesTotal = plan.createBytes + plan.updateBytes;
+    // Never delete on the strength of a comparison that could not read everything
+    const bool deleteExtra = options.deleteExtra && plan.errors.empty();
+    state.filesTotal = plan.creates + plan.updates + (deleteExtra ? plan.deletes - plan.replaces : 0);
+    // Files are synced in parallel; result and state are shared
+    std::mutex mutex;
+
+    using Clock = std::chrono::steady_clock;
+    auto lastReport = Clock::now();
+    auto reportLocked = [&](bool force) {
+        const auto now = Clock::now();
+        if (!force && now - lastReport < std::chrono::milliseconds(100)) return;
+        lastReport = now;
+        if (progress) progress(state);
+    };
+    auto fail = [&](const fs::path &path, int error) {
+        std::lock_guard<std::mutex> lock(mutex);
+        result.failures.push_back(path.string() + ": " + std::strerror(error));
+    };
+    auto finishItem = [&](const fs::path &path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++state.filesDone;
+        state.current = path.string();
+        reportLocked(false);
+    };
+
+    // Replacing deletes what is there; without deleteExtra the item and
+    // everything below a folder that could not be created are left out
+    std::unordered_set<std::string> keptDirs;
+    auto underKeptDir = [&keptDirs](const fs::path &rel) {
+        for (fs::path p = rel.parent_path(); !p.empty(); p = p.parent_path()) {
+            if (keptDirs.count(p.string())) return true;
+        }
+        return false;
+    };
+    auto keep = [&](const SyncItem &item, const fs::path &target) {
+        std::lock_guard<std::mutex> lock(mutex);
+        result.failures.push_back(target.string() + ": exists with another type; not replaced without deleting");
+        if (item.action == SyncItem::CreateDir) keptDirs.insert(item.relative);
+    };
+
+    // Deletions and folders are cheap and ordered; they run here, before any file
+    std::vector<const SyncItem *> files;
+    for (const SyncItem &item : plan.items) {
+        if (cancelled()) {
+            result.cancelled = true;
+            return result;
+        }
+        const fs::path target = dst / item.relative;
+        const bool underKept = item.action != SyncItem::Delete && underKeptDir(item.relative);
+        if (underKept || (item.replace && !deleteExtra)) {
+            if (!underKept) keep(item, target);
+            finishItem(target);
+            continue;
+        }
+        std::error_code ec;
+        switch (item.action) {
+        case SyncItem::Delete:
+            if (!deleteExtra) break;
+            fs::remove_all(target, ec);
+            if (ec) fail(target, ec.value());
+            finishItem(target);
+            break;
+        case SyncItem::CreateDir:
+            if (item.replace) fs::remove_all(target, ec);
+            if (ec || ::mkdir(target.c_str(), 0777) != 0) fail(target, ec ? ec.value() : errno);
+            finishItem(target);
+            break;
+        default:
+            files.push_back(&item);
+            break;
+        }
+    }
+
+    ThreadPool::bulk().parallelFor(files.size(), [&](std::size_t i) {
+        if (cancelled()) return;
+        const SyncItem &item = *files[i];
+        const fs::path from = src / item.relative;
+        const fs::path to = dst / item.relative;
+
+        std::error_code ec;
+        if (item.replace) {
+            fs::remove_all(to, ec);
+            if (ec) {
+                fail(to, ec.value());
+                finishItem(to);
+                return;
+            }
+        }
+
+        if (item.action == SyncItem::Symlink) {
+            const fs::path link = fs::read_symlink(from, ec);
+            if (!ec) ::unlink(to.c_str());
+            if (ec || ::symlink(link.c_str(), to.c_str()) != 0) fail(from, ec ? ec.value() : errno);
+            finishItem(to);
+            return;
+        }
+
+        std::uint64_t written = 0, matched = 0;
+        auto advance = [&](std::uint64_t bytes) {
+            std::lock_guard<std::mutex> lock(mutex);
+            state.bytesDone += bytes;
+            reportLocked(false);
+        };
+
+        int in = BatchOperation::openSource(from.string());
+        if (in < 0) {
+            fail(from, errno);
+            advance(item.size);
+            finishItem(to);
+            return;
+        }
+        struct stat st;
+        ::fstat(in, &st);
+        ::posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+        const bool delta = item.action == SyncItem::Update && item.size >= kDeltaThreshold;
+        const int flags = delta ? O_RDWR : O_WRONLY | O_CREAT | O_TRUNC;
+        int out = ::open(to.c_str(), flags | O_CLOEXEC, st.st_mode & 07777);
+        bool ok = out >= 0;
+        if (ok) {
+            if (delta) {
+                ::posix_fadvise(out, 0, 0, POSIX_FADV_SEQUENTIAL);
+                ok = patchBlocks(in, out, &written, &matched, advance, cancelled);
+            } else {
+                ok = BatchOperation::copyData(in, out, [&](std::uint64_t bytes) {
+                    written += bytes;
+                    advance(bytes);
+                }, cancelled);
+            }
+        }
+        const int error = errno;
+        if (ok) {
+            // The source mtime goes on last: an interrupted update keeps a
+            // mismatching mtime and is picked up again by the next sync
+            const struct timespec times[2] = {st.st_atim, st.st_mtim};
+            ::fchmod(out, st.st_mode & 07777);
+            ::futimens(out, times);
+        }
+        if (out >= 0) ::close(out);
+        ::close(in);
+
+        if (!ok && !cancelled()) fail(to, error);
+        if (!ok && item.action == SyncItem::Create) ::unlink(to.c_str());
+
+        std::lock_guard<std::mutex> lock(mutex);
+        result.bytesWritten += written;
+        result.bytesMatched += matched;
+        ++state.filesDone;
+        state.current = to.string();
+        reportLocked(false);
+    });
+
+    if (cancelled()) result.cancelled = true;
+    std::lock_guard<std::mutex> lock(mutex);
+    reportLocked(true);
+    return result;
+}
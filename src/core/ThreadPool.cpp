@@ -0,0 +1,92 @@
+#include "core/ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(std::size_t workers) {
+    workers = std::max<std::size_t>(workers, 1);
+    m_workers.reserve(workers);
+    for (std::size_t i = 0; i < workers; ++i) {
+        m_workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cv.notify_all();
+    for (auto &worker : m_workers) {
+        worker.join();
+    }
+}
+
+ThreadPool &ThreadPool::shared() {
+    static ThreadPool pool(std::clamp<std::size_t>(std::thread::hardware_concurrency(), 2, 8));
+    return pool;
+}
+
+ThreadPool &ThreadPool::bulk() {
+    static ThreadPool pool(std::clamp<std::size_t>(std::thread::hardware_concurrency() / 2, 2, 4));
+    return pool;
+}
+
+ThreadPool &ThreadPool::listing() {
+    static ThreadPool pool(2);
+    return pool;
+}
+
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)> &fn) {
+    struct State {
+        std::atomic<std::size_t> next{0};
+        std::mutex mutex;
+        std::condition_variable idle;
+        std::size_t active = 0;
+        bool closed = false; // set once the caller is done; late helpers must not touch fn
+    };
+    auto state = std::make_shared<State>();
+    auto drain = [state, count, &fn]() {
+        for (std::size_t i; (i = state->next.fetch_add(1)) < count;) fn(i);
+    };
+
+    const std::size_t helpers = std::min(count, m_workers.size() + 1) - (count > 0 ? 1 : 0);
+    for (std::size_t h = 0; h < helpers; ++h) {
+        enqueue([state, drain]() {
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (state->closed) return;
+                ++state->active;
+            }
+            drain();
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (--state->active == 0) state->idle.notify_all();
+        });
+    }
+
+    drain();
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->closed = true;
+    state->idle.wait(lock, [&state]() { return state->active == 0; });
+}
+
+void ThreadPool::enqueue(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(std::move(job));
+    }
+    m_cv.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+            // Drain what is queued before exiting so futures never dangle
+            if (m_queue.empty()) return;
+            job = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        job();
+    }
+}
@@ -1,10 +1,56 @@
 #include <QApplication>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <cstdio>
 #include "ui/MainWindow.h"
 
+// `raefile --startup-probe` reports the time from main() to the first paint
+// of a populated home listing, then exits. Used to keep cold start in check.
+class StartupProbe : public QObject {
+public:
+    StartupProbe(MainWindow *window, const QElapsedTimer &clock)
+        : QObject(window), m_clock(clock), m_viewport(window->fileView()->viewport()) {
+        connect(window->fileModel(), &DirectoryModel::directoryLoaded, this, [this](const QString &) {
+            m_loadedMs = m_clock.elapsed();
+            m_viewport->update();
+        });
+        m_viewport->installEventFilter(this);
+    }
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override {
+        if (watched == m_viewport && event->type() == QEvent::Paint && m_loadedMs >= 0 && !m_reported) {
+            m_reported = true;
+            // Report once the paint in flight has actually been handled
+            QTimer::singleShot(0, this, [this]() {
+                std::printf("startup: listing loaded %lld ms, first painted %lld ms\n",
+                            static_cast<long long>(m_loadedMs), static_cast<long long>(m_clock.elapsed()));
+                std::fflush(stdout);
+                QCoreApplication::quit();
+            });
+        }
+        return QObject::eventFilter(watched, event);
+    }
+
+private:
+    QElapsedTimer m_clock;
+    QWidget *m_viewport;
+    qint64 m_loadedMs = -1;
+    bool m_reported = false;
+};
+
 int main(int argc, char *argv[]) {
+    QElapsedTimer clock;
+    clock.start();
+
     QApplication app(argc, argv);
+    QCoreApplication::setOrganizationName("Raefile");
+    QCoreApplication::setApplicationName("Raefile");
     
     MainWindow window;
+    if (app.arguments().contains("--startup-probe")) {
+        new StartupProbe(&window, clock);
+    }
     window.show();
     
     return app.exec();
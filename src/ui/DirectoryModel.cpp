@@ -0,0 +1,277 @@
+#include "ui/DirectoryModel.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QLocale>
+#include <algorithm>
+
+DirectoryModel::DirectoryModel(FileSystemEngine *engine, QObject *parent)
+    : QAbstractTableModel(parent), m_engine(engine), m_watcher(new DirectoryWatcher(this)),
+      m_pollTimer(new QTimer(this)) {
+    m_pollTimer->setSingleShot(true);
+    m_pollTimer->setInterval(kPollMs);
+    connect(m_pollTimer, &QTimer::timeout, this, &DirectoryModel::poll);
+    connect(m_watcher, &DirectoryWatcher::changed, this, &DirectoryModel::applyChanges);
+    connect(m_watcher, &DirectoryWatcher::overflowed, this, &DirectoryModel::reload);
+}
+
+void DirectoryModel::setIcons(const QIcon &folder, const QIcon &file) {
+    m_folderIcon = folder;
+    m_fileIcon = file;
+}
+
+void DirectoryModel::setDirectory(const QString &path) {
+    m_path = path;
+    beginResetModel();
+    m_rows.clear();
+    m_byName.clear();
+    endResetModel();
+    reload();
+}
+
+void DirectoryModel::reload() {
+    // Watch first so nothing that happens during the listing is missed.
+    // Names flushed before the listing arrives are held and re-stat'ed on
+    // top of it, since the snapshot may have been read before they changed.
+    // Without a watch, changes are found by listing again every few seconds.
+    if (m_watcher->watch(m_path)) m_pollTimer->stop();
+    else m_pollTimer->start();
+
+    const quint64 generation = ++m_generation;
+    m_listing = true;
+    m_heldChanges.clear();
+    m_engine->listDirectoryAsync(m_path, [this, generation](QVector<FileInfo> entries) {
+        QMetaObject::invokeMethod(this, [this, generation, entries = std::move(entries)]() mutable {
+            applyListing(generation, std::move(entries));
+        });
+    });
+}
+
+void DirectoryModel::applyListing(quint64 generation, QVector<FileInfo> entries) {
+    if (generation != m_generation) return; // superseded by a newer listing
+
+    if (!m_showHidden) {
+        entries.erase(std::remove_if(entries.begin(), entries.end(), [](const FileInfo &info) { return info.isHidden; }),
+                      entries.end());
+    }
+    std::sort(entries.begin(), entries.end(), [this](const FileInfo &a, const FileInfo &b) { return lessThan(a, b); });
+
+    beginResetModel();
+    m_rows = std::move(entries);
+    m_byName.clear();
+    m_byName.reserve(m_rows.size());
+    for (const auto &info : m_rows) m_byName.insert(info.name, info);
+    endResetModel();
+
+    // The snapshot may predate changes flushed while it was being read
+    m_listing = false;
+    if (!m_heldChanges.isEmpty()) {
+        const QStringList held(m_heldChanges.begin(), m_heldChanges.end());
+        m_heldChanges.clear();
+        applyChanges(held);
+    }
+
+    emit directoryLoaded(m_path);
+}
+
+void DirectoryModel::applyChanges(const QStringList &names) {
+    if (m_listing) {
+        for (const QString &name : names) m_heldChanges.insert(name);
+        return;
+    }
+    for (const QString &name : names) {
+        FileInfo fresh;
+        const bool exists = FileSystemEngine::statEntry(m_path, name, &fresh);
+        const bool visible = exists && (m_showHidden || !fresh.isHidden);
+        const int row = rowOf(name);
+
+        if (row >= 0 && !visible) {
+            beginRemoveRows(QModelIndex(), row, row);
+            m_rows.remove(row);
+            m_byName.remove(name);
+            endRemoveRows();
+        } else if (row < 0 && visible) {
+            const int at = insertPosition(fresh);
+            beginInsertRows(QModelIndex(), at, at);
+            m_rows.insert(at, fresh);
+            m_byName.insert(name, fresh);
+            endInsertRows();
+        } else if (row >= 0) {
+            const FileInfo &old = m_rows[row];
+            if (old.size == fresh.size && old.modified == fresh.modified && old.isDir == fresh.isDir &&
+                old.permissions == fresh.permissions) {
+                continue;
+            }
+
+            // A new size or mtime can move the row when sorted by that column
+            FileInfo moved = m_rows.takeAt(row);
+            m_byName.remove(name);
+            const int at = insertPosition(fresh);
+            m_rows.insert(row, moved);
+
+            if (at != row) {
+                beginMoveRows(QModelIndex(), row, row, QModelIndex(), at > row ? at + 1 : at);
+                m_rows.remove(row);
+                m_rows.insert(at, fresh);
+                endMoveRows();
+            } else {
+                m_rows[row] = fresh;
+            }
+            m_byName.insert(name, fresh);
+            emit dataChanged(index(at, 0), index(at, ColumnCount - 1));
+        }
+    }
+}
+
+void DirectoryModel::poll() {
+    if (m_listing) { // a reload is already on its way
+        m_pollTimer->start();
+        return;
+    }
+    const quint64 generation = ++m_generation;
+    m_engine->listDirectoryAsync(m_path, [this, generation](QVector<FileInfo> entries) {
+        QMetaObject::invokeMethod(this, [this, generation, entries = std::move(entries)]() {
+            applyPoll(generation, entries);
+        });
+    });
+}
+
+void DirectoryModel::applyPoll(quint64 generation, const QVector<FileInfo> &entries) {
+    if (generation != m_generation) return; // superseded by a reload
+
+    // Only what differs from the rows is re-stat'ed, so selection and scroll
+    // position survive the relist
+    QStringList names;
+    QSet<QString> seen;
+    for (const auto &info : entries) {
+        if (info.isHidden && !m_showHidden) continue;
+        seen.insert(info.name);
+        auto it = m_byName.constFind(info.name);
+        if (it == m_byName.constEnd() || it->size != info.size || it->modified != info.modified ||
+            it->isDir != info.isDir || it->permissions != info.permissions) {
+            names << info.name;
+        }
+    }
+    for (auto it = m_byName.constBegin(); it != m_byName.constEnd(); ++it) {
+        if (!seen.contains(it.key())) names << it.key();
+    }
+    applyChanges(names);
+    m_pollTimer->start();
+}
+
+void DirectoryModel::setShowHidden(bool show) {
+    if (show == m_showHidden) return;
+    m_showHidden = show;
+    reload();
+}
+
+bool DirectoryModel::lessThan(const FileInfo &a, const FileInfo &b) const {
+    // Folders stay on top in either direction, like QFileSystemModel
+    if (a.isDir != b.isDir) return a.isDir;
+
+    int cmp = 0;
+    switch (m_sortColumn) {
+    case SizeColumn: cmp = a.size < b.size ? -1 : (a.size > b.size ? 1 : 0); break;
+    case TypeColumn: cmp = QString::compare(a.type, b.type, Qt::CaseInsensitive); break;
+    case ModifiedColumn: cmp = a.modified < b.modified ? -1 : (a.modified > b.modified ? 1 : 0); break;
+    default: break;
+    }
+    if (cmp == 0) cmp = QString::compare(a.name, b.name, Qt::CaseInsensitive);
+    // Names are unique; this keeps the order total for binary search
+    if (cmp == 0) cmp = QString::compare(a.name, b.name, Qt::CaseSensitive);
+    return m_sortOrder == Qt::AscendingOrder ? cmp < 0 : cmp > 0;
+}
+
+int DirectoryModel::insertPosition(const FileInfo &info) const {
+    auto it = std::lower_bound(m_rows.begin(), m_rows.end(), info,
+                               [this](const FileInfo &a, const FileInfo &b) { return lessThan(a, b); });
+    return static_cast<int>(it - m_rows.begin());
+}
+
+int DirectoryModel::rowOf(const QString &name) const {
+    auto it = m_byName.constFind(name);
+    if (it == m_byName.constEnd()) return -1;
+    const int row = insertPosition(it.value());
+    return row < m_rows.size() && m_rows[row].name == name ? row : -1;
+}
+
+void DirectoryModel::sort(int column, Qt::SortOrder order) {
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+    const QModelIndexList persistent = persistentIndexList();
+    QVector<QPair<QString, int>> anchors;
+    anchors.reserve(persistent.size());
+    for (const QModelIndex &index : persistent) anchors.append({m_rows[index.row()].name, index.column()});
+
+    m_sortColumn = column;
+    m_sortOrder = order;
+    std::sort(m_rows.begin(), m_rows.end(), [this](const FileInfo &a, const FileInfo &b) { return lessThan(a, b); });
+
+    QModelIndexList moved;
+    moved.reserve(anchors.size());
+    for (const auto &anchor : anchors) moved << index(rowOf(anchor.first), anchor.second);
+    changePersistentIndexList(persistent, moved);
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
+
+QString DirectoryModel::filePath(const QModelIndex &index) const {
+    return index.isValid() ? m_rows[index.row()].absolutePath : QString();
+}
+
+QString DirectoryModel::fileName(const QModelIndex &index) const {
+    return index.isValid() ? m_rows[index.row()].name : QString();
+}
+
+bool DirectoryModel::isDir(const QModelIndex &index) const {
+    return index.isValid() && m_rows[index.row()].isDir;
+}
+
+QModelIndex DirectoryModel::indexOf(const QString &path) const {
+    QFileInfo info(path);
+    if (QDir::cleanPath(info.path()) != QDir::cleanPath(m_path)) return QModelIndex();
+    const int row = rowOf(info.fileName());
+    return row >= 0 ? index(row, 0) : QModelIndex();
+}
+
+int DirectoryModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+int DirectoryModel::columnCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant DirectoryModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= m_rows.size()) return QVariant();
+    const FileInfo &info = m_rows[index.row()];
+
+    switch (role) {
+    case Qt::DisplayRole:
+        switch (index.column()) {
+        case NameColumn: return info.name;
+        case SizeColumn: return info.isDir ? QString() : QLocale().formattedDataSize(info.size);
+        case TypeColumn: return info.type;
+        case ModifiedColumn: return QLocale().toString(info.modified, QLocale::ShortFormat);
+        }
+        break;
+    case Qt::DecorationRole:
+        if (index.column() == NameColumn) return info.isDir ? m_folderIcon : m_fileIcon;
+        break;
+    case Qt::ToolTipRole:
+        if (index.column() == NameColumn) return info.permissions;
+        break;
+    case Qt::TextAlignmentRole:
+        if (index.column() == SizeColumn) return int(Qt::AlignRight | Qt::AlignVCenter);
+        break;
+    }
+    return QVariant();
+}
+
+QVariant DirectoryModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) return QVariant();
+    switch (section) {
+    case NameColumn: return "Name";
+    case SizeColumn: return "Size";
+    case TypeColumn: return "Type";
+    case ModifiedColumn: return "Date Modified";
+    }
+    return QVariant();
+}
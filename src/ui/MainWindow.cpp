@@ -11,29 +11,90 @@
 #include <QSplitter>
 #include <QLabel>
 #include <QToolButton>
-#include <QCoreApplication>
+#include <QHash>
+#include <QSettings>
+#include <QTimer>
 #include <QFile>
+#include <QFileDialog>
+#include <QLocale>
+#include <algorithm>
+#include <limits>
+
+static QIcon assetIcon(const QString &name) {
+    // Assets are compiled in (resources.qrc); share one QIcon per asset so
+    // repeated lookups (search hits, menus) never touch the resource tree again
+    static QHash<QString, QIcon> cache;
+    auto it = cache.find(name);
+    if (it == cache.end()) {
+        it = cache.insert(name, QIcon(":/assets/" + name));
+    }
+    return it.value();
+}
 
-static QString getAssetPath(const QString &name) {
-    // Try executable path first (deployment friendly)
-    QString path = QCoreApplication::applicationDirPath() + "/assets/" + name;
-    if (QFile::exists(path)) return path;
-    
-    // Fallback to relative (development)
-    return "assets/" + name;
+// Message boxes list at most ten entries
+static QStringList firstLines(const std::vector<std::string> &items, const QString &indent = QString()) {
+    QStringList lines;
+    for (const auto &item : items) {
+        if (lines.size() == 10) { lines << "..."; break; }
+        lines << indent + QString::fromStdString(item);
+    }
+    return lines;
+}
+
+static int percentDone(const BatchProgress &p) {
+    if (p.bytesTotal) return int(p.bytesDone * 100 / p.bytesTotal);
+    return p.filesTotal ? int(p.filesDone * 100 / p.filesTotal) : 100;
+}
+
+static std::vector<std::string> toStdPaths(const QStringList &paths) {
+    std::vector<std::string> out;
+    for (const auto &p : paths) {
+        if (!p.isEmpty()) out.push_back(QDir::cleanPath(p).toStdString());
+    }
+    return out;
+}
+
+// Search scope is user-configurable through the settings file:
+//   [search] roots, excluded, oneFileSystem, includeNetwork, includeFuse,
+//            includeOverlay, includeVirtual, maxHits
+static SearchScopeOptions loadSearchScope() {
+    QSettings settings;
+    settings.beginGroup("search");
+    SearchScopeOptions options;
+    if (settings.contains("roots")) options.roots = toStdPaths(settings.value("roots").toStringList());
+    if (settings.contains("excluded")) options.excludedPaths = toStdPaths(settings.value("excluded").toStringList());
+    options.oneFileSystem = settings.value("oneFileSystem", options.oneFileSystem).toBool();
+    options.includeNetwork = settings.value("includeNetwork", options.includeNetwork).toBool();
+    options.includeFuse = settings.value("includeFuse", options.includeFuse).toBool();
+    options.includeOverlay = settings.value("includeOverlay", options.includeOverlay).toBool();
+    options.includeVirtual = settings.value("includeVirtual", options.includeVirtual).toBool();
+    return options;
 }
 
 MainWindow::MainWindow(QWidget *parent) 
-    : QMainWindow(parent), m_engine(new FileSystemEngine(this)), m_isCut(false) {
+    : QMainWindow(parent), m_engine(new FileSystemEngine(this)), m_searchList(nullptr), m_searchModel(nullptr), m_isCut(false) {
     applyModernStyle();
     setupUI();
+
+    // Point the model at home first so the listing runs while
+    // the rest of the window is still being built
+    goHome();
+
     setupActions();
-    setupShortcuts();
     
     // Icon
-    setWindowIcon(QIcon(getAssetPath("logo.png")));
+    setWindowIcon(assetIcon("logo.png"));
 
-    goHome();
+    // Nothing below is needed for the first frame
+    QTimer::singleShot(0, this, &MainWindow::setupShortcuts);
+}
+
+MainWindow::~MainWindow() {
+    // Walk and batch callbacks capture `this`; make sure none is still running
+    m_engine->stopSearch();
+    m_engine->cancelBatches();
+    m_engine->waitForSearch();
+    m_engine->waitForJobs();
 }
 
 void MainWindow::applyModernStyle() {
@@ -84,10 +145,10 @@ void MainWindow::applyModernStyle() {
             font-weight: bold;
         }
         
-        QListWidget { background-color: #1A1A1A; border: 1px solid #333333; outline: none; }
-        QListWidget::item { padding: 6px; border-radius: 2px; margin: 2px; }
-        QListWidget::item:hover { background-color: #2A2A2A; }
-        QListWidget::item:selected { background-color: #005FB8; color: #FFFFFF; }
+        QListView { background-color: #1A1A1A; border: 1px solid #333333; outline: none; }
+        QListView::item { padding: 6px; border-radius: 2px; margin: 2px; }
+        QListView::item:hover { background-color: #2A2A2A; }
+        QListView::item:selected { background-color: #005FB8; color: #FFFFFF; }
         
         QToolBar { 
             background-color: #202020; 
@@ -125,29 +186,6 @@ void MainWindow::applyModernStyle() {
     )");
 }
 
-class SearchResultItem : public QListWidgetItem {
-public:
-    SearchResultItem(const FileInfo &info, QListWidget *parent) 
-        : QListWidgetItem(parent), m_info(info) {
-        setText(info.absolutePath);
-        setData(Qt::UserRole, info.absolutePath);
-        setToolTip(info.isDir ? "Directory" : "File");
-        setIcon(QIcon(getAssetPath(info.isDir ? "ic_folder.png" : "ic_file.png")));
-    }
-    
-    bool operator<(const QListWidgetItem &other) const override {
-        // Sort descending by score
-        const SearchResultItem *o = static_cast<const SearchResultItem*>(&other);
-        return m_info.score < o->m_info.score; // Default is ascending, we want descending sorting usually, but QListWidget sorts ascending by default. 
-        // Logic: if current < other, current comes first? No. 
-        // We will setSortOrder(Qt::DescendingOrder). So larger score should be "greater".
-        // Therefore: return m_info.score < o->m_info.score is correct for numeric comparison.
-    }
-    
-private:
-    FileInfo m_info;
-};
-
 void MainWindow::setupUI() {
     setWindowTitle("Raefile - File Manager");
     resize(1100, 750);
@@ -164,7 +202,7 @@ void MainWindow::setupUI() {
     
     // Up Button
     QToolButton *upBtn = new QToolButton(this);
-    upBtn->setIcon(QIcon(getAssetPath("ic_arrow_up.png")));
+    upBtn->setIcon(assetIcon("ic_arrow_up.png"));
     upBtn->setToolTip("Up");
     upBtn->setFixedSize(32, 32); // Ensure size
     upBtn->setIconSize(QSize(20, 20));
@@ -173,7 +211,7 @@ void MainWindow::setupUI() {
     
     // Refresh Button
     QToolButton *refreshBtn = new QToolButton(this);
-    refreshBtn->setIcon(QIcon(getAssetPath("ic_refresh.png")));
+    refreshBtn->setIcon(assetIcon("ic_refresh.png"));
     refreshBtn->setToolTip("Refresh");
     refreshBtn->setFixedSize(32, 32); // Ensure size
     refreshBtn->setIconSize(QSize(20, 20));
@@ -187,7 +225,7 @@ void MainWindow::setupUI() {
     m_pathEdit->setPlaceholderText("Path...");
     
     m_searchEdit = new QLineEdit(this);
-    m_searchEdit->setPlaceholderText("Global Search...");
+    m_searchEdit->setPlaceholderText("Global Search... (ext:log size:>1G mtime:<7d path:/srv)");
     
     topLayout->addWidget(m_pathEdit, 7);
     topLayout->addWidget(m_searchEdit, 3);
@@ -226,9 +264,13 @@ void MainWindow::setupUI() {
     
     // Page 0: Tree View
     m_treeView = new QTreeView(this);
-    m_model = new QFileSystemModel(this);
-    m_model->setRootPath("");
+    m_model = new DirectoryModel(m_engine, this);
+    m_model->setIcons(assetIcon("ic_folder.png"), assetIcon("ic_file.png"));
     m_treeView->setModel(m_model);
+    // The model lists one folder at a time; navigation replaces expansion
+    m_treeView->setRootIsDecorated(false);
+    m_treeView->setItemsExpandable(false);
+    m_treeView->setUniformRowHeights(true);
     m_treeView->setContextMenuPolicy(Qt::CustomContextMenu);
     m_treeView->setSelectionMode(QAbstractItemView::ExtendedSelection);
     m_treeView->header()->setStretchLastSection(true);
@@ -245,13 +287,17 @@ void MainWindow::setupUI() {
     
     connect(m_treeView, &QTreeView::customContextMenuRequested, this, &MainWindow::showContextMenu);
     connect(m_treeView, &QTreeView::doubleClicked, this, &MainWindow::onFileDoubleClicked);
+    connect(m_model, &DirectoryModel::directoryLoaded, this, [this]() {
+        if (m_pendingSelection.isEmpty()) return;
+        QModelIndex index = m_model->indexOf(m_pendingSelection);
+        m_pendingSelection.clear();
+        if (!index.isValid()) return;
+        m_treeView->setCurrentIndex(index);
+        m_treeView->scrollTo(index);
+    });
     
-    // Page 1: Search List
-    m_searchList = new QListWidget(this);
-    connect(m_searchList, &QListWidget::itemDoubleClicked, this, &MainWindow::onSearchResultClicked);
-    
+    // Page 1: Search List (created on first search, see ensureSearchList)
     m_stackWidget->addWidget(m_treeView);
-    m_stackWidget->addWidget(m_searchList);
     
     rightLayout->addWidget(m_stackWidget);
     
@@ -274,13 +320,25 @@ void MainWindow::setupUI() {
     // statusBar()->showMessage("Ready"); // Removed to avoid gap
 }
 
+void MainWindow::ensureSearchList() {
+    if (m_searchList) return;
+    m_searchModel = new SearchResultModel(this);
+    m_searchModel->setIcons(assetIcon("ic_folder.png"), assetIcon("ic_file.png"));
+    m_searchList = new QListView(this);
+    // Every row has the same height; lets the view skip measuring millions of rows
+    m_searchList->setUniformItemSizes(true);
+    m_searchList->setModel(m_searchModel);
+    connect(m_searchList, &QListView::doubleClicked, this, &MainWindow::onSearchResultClicked);
+    m_stackWidget->addWidget(m_searchList);
+}
+
 void MainWindow::setupSidebar() {
     m_sideBar = new QListWidget(this);
     m_sideBar->setFixedWidth(240);
     m_sideBar->setIconSize(QSize(32, 32));
     
     auto addItem = [this](const QString &name, const QString &iconName) {
-        QListWidgetItem *item = new QListWidgetItem(QIcon(getAssetPath(iconName)), name);
+        QListWidgetItem *item = new QListWidgetItem(assetIcon(iconName), name);
         m_sideBar->addItem(item);
     };
     
@@ -326,6 +384,13 @@ void MainWindow::setupActions() {
     m_toolBar->addSeparator();
     m_toolBar->addAction("New Folder", this, &MainWindow::createNewFolder);
     m_toolBar->addAction("New File", this, &MainWindow::createNewFile);
+
+    m_toolBar->addSeparator();
+    m_verifyAct = m_toolBar->addAction("Verify Copies");
+    m_verifyAct->setCheckable(true);
+    m_verifyAct->setToolTip("Checksum pasted files and re-read them from disk");
+    m_verifyAct->setChecked(QSettings().value("paste/verify", false).toBool());
+    connect(m_verifyAct, &QAction::toggled, this, [](bool on) { QSettings().setValue("paste/verify", on); });
     // Removed File Ops from Toolbar as per request
 }
 
@@ -380,7 +445,12 @@ void MainWindow::onDirectoryLoaded(const QString &path) {
     if (QDir(path).exists()) {
         m_stackWidget->setCurrentIndex(0); // Show Tree View
         m_pathEdit->setText(path);
-        m_treeView->setRootIndex(m_model->index(path));
+        // Only the shown directory is listed and watched
+        if (path == m_model->directory()) {
+            m_model->reload();
+        } else {
+            m_model->setDirectory(path);
+        }
     }
 }
 
@@ -439,39 +509,235 @@ void MainWindow::renameSelected() {
     }
 }
 
+QStringList MainWindow::selectedPaths() const {
+    QStringList paths;
+    for (const auto &index : m_treeView->selectionModel()->selectedRows()) {
+        paths << m_model->filePath(index);
+    }
+    if (paths.isEmpty() && m_treeView->currentIndex().isValid()) {
+        paths << m_model->filePath(m_treeView->currentIndex());
+    }
+    return paths;
+}
+
 void MainWindow::copySelected() {
-    auto index = m_treeView->currentIndex();
-    if (index.isValid()) {
-        m_copyPath = m_model->filePath(index);
+    QStringList paths = selectedPaths();
+    if (!paths.isEmpty()) {
+        m_clipboard = paths;
         m_isCut = false;
-        statusBar()->showMessage("Copied: " + m_model->fileName(index));
+        statusBar()->showMessage(QString("Copied %1 item(s)").arg(paths.size()));
     }
 }
 
 void MainWindow::cutSelected() {
-    auto index = m_treeView->currentIndex();
-    if (index.isValid()) {
-        m_copyPath = m_model->filePath(index);
+    QStringList paths = selectedPaths();
+    if (!paths.isEmpty()) {
+        m_clipboard = paths;
         m_isCut = true;
-        statusBar()->showMessage("Cut: " + m_model->fileName(index));
+        statusBar()->showMessage(QString("Cut %1 item(s)").arg(paths.size()));
     }
 }
 
 void MainWindow::pasteToCurrent() {
-    if (m_copyPath.isEmpty()) return;
-    
-    QString dest = QDir(m_pathEdit->text()).filePath(QFileInfo(m_copyPath).fileName());
-    bool success = false;
-    if (m_isCut) {
-        success = m_engine->move(m_copyPath, dest);
-        m_copyPath = ""; // Clear after move
-    } else {
-        success = m_engine->copy(m_copyPath, dest);
+    if (m_clipboard.isEmpty()) return;
+
+    QStringList sources = m_clipboard;
+    BatchMode mode = m_isCut ? BatchMode::Move : BatchMode::Copy;
+    if (m_isCut) m_clipboard.clear(); // Clear after move
+
+    statusBar()->showMessage("Preparing paste...");
+    m_engine->planBatchAsync(sources, m_pathEdit->text(), mode,
+                             [this](std::shared_ptr<BatchPlan> plan) {
+        QMetaObject::invokeMethod(this, [this, plan]() { onBatchPlanned(plan); });
+    });
+}
+
+void MainWindow::onBatchPlanned(std::shared_ptr<BatchPlan> plan) {
+    if (!plan->errors.empty()) {
+        const QStringList lines = firstLines(plan->errors);
+        if (plan->items.empty()) {
+            statusBar()->clearMessage();
+            QMessageBox::warning(this, "Error", "Paste operation failed.\n\n" + lines.join("\n"));
+            return;
+        }
+        auto reply = QMessageBox::question(this, "Paste", "Some items cannot be pasted:\n\n" + lines.join("\n") +
+                                           "\n\nContinue with the rest?", QMessageBox::Yes | QMessageBox::No);
+        if (reply != QMessageBox::Yes) {
+            statusBar()->clearMessage();
+            return;
+        }
     }
-    
-    if (!success) {
-        QMessageBox::warning(this, "Error", "Paste operation failed.");
+
+    ConflictPolicy policy = ConflictPolicy::Overwrite;
+    if (plan->conflicts > 0) {
+        QMessageBox box(QMessageBox::Question, "Paste",
+                        QString("%1 item(s) already exist in the destination.").arg(plan->conflicts),
+                        QMessageBox::NoButton, this);
+        QPushButton *overwrite = box.addButton("Overwrite", QMessageBox::AcceptRole);
+        QPushButton *skip = box.addButton("Skip", QMessageBox::RejectRole);
+        box.addButton(QMessageBox::Cancel);
+        box.exec();
+        if (box.clickedButton() == overwrite) policy = ConflictPolicy::Overwrite;
+        else if (box.clickedButton() == skip) policy = ConflictPolicy::Skip;
+        else {
+            statusBar()->clearMessage();
+            return;
+        }
+    }
+
+    BatchOptions options;
+    options.conflicts = policy;
+    options.verify = m_verifyAct->isChecked();
+
+    const QString verb = plan->mode == BatchMode::Move ? "Moving" : "Copying";
+    m_engine->runBatchAsync(plan, options, [this, verb](const BatchProgress &p) {
+        QString message = QString("%1 %2/%3 item(s) (%4%)").arg(verb).arg(p.filesDone).arg(p.filesTotal).arg(percentDone(p));
+        QMetaObject::invokeMethod(this, [this, message]() { statusBar()->showMessage(message); });
+    }, [this](const BatchResult &result) {
+        const QStringList failures = firstLines(result.failures);
+        const bool cancelled = result.cancelled;
+        const size_t verified = result.verified;
+        QMetaObject::invokeMethod(this, [this, failures, cancelled, verified]() {
+            if (cancelled) {
+                statusBar()->showMessage("Paste cancelled");
+            } else if (!failures.isEmpty()) {
+                statusBar()->clearMessage();
+                QMessageBox::warning(this, "Error", "Paste operation failed.\n\n" + failures.join("\n"));
+            } else if (verified > 0) {
+                statusBar()->showMessage(QString("Paste finished, %1 file(s) verified").arg(verified), 3000);
+            } else {
+                statusBar()->showMessage("Paste finished", 3000);
+            }
+        });
+    });
+}
+
+void MainWindow::verifyChecksums() {
+    runVerify(false);
+}
+
+void MainWindow::addChecksums() {
+    runVerify(true);
+}
+
+void MainWindow::runVerify(bool addNew) {
+    // A selected folder, otherwise the folder being shown
+    QString dir = m_pathEdit->text();
+    auto index = m_treeView->currentIndex();
+    if (index.isValid() && m_model->isDir(index)) dir = m_model->filePath(index);
+
+    if (!QFile::exists(QString::fromStdString(ChecksumManifest::pathFor(dir.toStdString())))) {
+        QMessageBox::information(this, "Verify Checksums", "No checksum manifest in this folder. Paste into it with \"Verify Copies\" enabled first.");
+        return;
     }
+
+    statusBar()->showMessage("Verifying " + dir + "...");
+    m_engine->verifyManifestAsync(dir, addNew, [this, dir, addNew](const VerifyReport &report) {
+        auto list = [](const std::vector<std::string> &paths) { return firstLines(paths, "  ").join("\n"); };
+        QString summary = QString("%1 file(s) intact, %2 corrupt, %3 changed, %4 missing.")
+            .arg(report.verified).arg(report.corrupt.size()).arg(report.changed.size()).arg(report.missing.size());
+        if (!report.unreadable.empty()) summary += QString(" %1 could not be read.").arg(report.unreadable.size());
+        if (addNew) summary += QString(" %1 new file(s) added.").arg(report.added.size());
+        if (!report.corrupt.empty()) summary += "\n\nCorrupt:\n" + list(report.corrupt);
+        if (!report.unreadable.empty()) summary += "\n\nUnreadable:\n" + list(report.unreadable);
+        if (!report.missing.empty()) summary += "\n\nMissing:\n" + list(report.missing);
+        const bool cancelled = report.cancelled;
+        const bool bad = !report.corrupt.empty() || !report.unreadable.empty();
+
+        QMetaObject::invokeMethod(this, [this, dir, summary, cancelled, bad]() {
+            statusBar()->clearMessage();
+            if (cancelled) return;
+            if (bad) QMessageBox::warning(this, "Verify Checksums", dir + "\n\n" + summary);
+            else QMessageBox::information(this, "Verify Checksums", dir + "\n\n" + summary);
+        });
+    });
+}
+
+void MainWindow::syncTo() {
+    // A selected folder, otherwise the folder being shown
+    QString source = m_pathEdit->text();
+    auto index = m_treeView->currentIndex();
+    if (index.isValid() && m_model->isDir(index)) source = m_model->filePath(index);
+
+    QString destination = QFileDialog::getExistingDirectory(this, "Sync \"" + QFileInfo(source).fileName() + "\" To", source);
+    if (destination.isEmpty()) return;
+
+    statusBar()->showMessage("Comparing " + source + " with " + destination + "...");
+    m_engine->planSyncAsync(source, destination, [this](std::shared_ptr<SyncPlan> plan) {
+        QMetaObject::invokeMethod(this, [this, plan]() { onSyncPlanned(plan); });
+    });
+}
+
+void MainWindow::onSyncPlanned(std::shared_ptr<SyncPlan> plan) {
+    statusBar()->clearMessage();
+    const QStringList errors = firstLines(plan->errors);
+    if (plan->items.empty()) {
+        if (!errors.isEmpty()) QMessageBox::warning(this, "Sync", "Sync failed.\n\n" + errors.join("\n"));
+        else QMessageBox::information(this, "Sync", QString("Already in sync, %1 item(s) unchanged.").arg(plan->unchanged));
+        return;
+    }
+
+    // The plan is the dry run: show it in full before anything is written
+    const QLocale locale;
+    QString summary = QString("%1\n  to %2\n\n%3 to create (%4), %5 to update (%6, changed blocks only), "
+                              "%7 to delete, %8 unchanged (%9).")
+        .arg(QString::fromStdString(plan->source), QString::fromStdString(plan->destination))
+        .arg(plan->creates).arg(locale.formattedDataSize(plan->createBytes))
+        .arg(plan->updates).arg(locale.formattedDataSize(plan->updateBytes))
+        .arg(plan->deletes).arg(plan->unchanged).arg(locale.formattedDataSize(plan->unchangedBytes));
+    // Deleting is only offered when the whole source could be read (see SyncOperation::run)
+    const bool canDelete = plan->deletes > 0 && plan->errors.empty();
+    if (!errors.isEmpty()) summary += "\n\nSome items cannot be synced:\n" + errors.join("\n");
+    if (plan->deletes > 0 && !canDelete) summary += "\n\nNothing will be deleted because part of the source could not be read.";
+    if (plan->replaces > 0) {
+        summary += QString("\n\n%1 of the deletions replace an entry of another type (e.g. a folder where the source has a file).")
+            .arg(plan->replaces);
+    }
+
+    QStringList details;
+    for (const auto &item : plan->items) {
+        if (details.size() >= 1000) { details << "..."; break; }
+        const QString rel = QString::fromStdString(item.relative);
+        if (item.action == SyncItem::Delete || item.replace) {
+            if (!canDelete) continue; // left alone, see above
+            details << QString("delete").leftJustified(8) + rel;
+            if (item.action == SyncItem::Delete) continue;
+        }
+        static const char *const verbs[] = {"create", "create", "update", "link", "delete"};
+        details << QString::fromLatin1(verbs[item.action]).leftJustified(8) + rel;
+    }
+
+    QMessageBox box(QMessageBox::Question, "Sync", summary, QMessageBox::NoButton, this);
+    box.setDetailedText(details.join("\n"));
+    QPushButton *mirror = box.addButton(canDelete ? "Mirror (Delete Extra)" : "Sync", QMessageBox::AcceptRole);
+    QPushButton *keep = canDelete ? box.addButton("Sync Without Deleting", QMessageBox::AcceptRole) : nullptr;
+    box.addButton(QMessageBox::Cancel);
+    box.exec();
+    if (box.clickedButton() != mirror && (!keep || box.clickedButton() != keep)) return;
+
+    SyncOptions options;
+    options.deleteExtra = canDelete && box.clickedButton() == mirror;
+
+    m_engine->runSyncAsync(plan, options, [this](const BatchProgress &p) {
+        QString message = QString("Syncing %1/%2 item(s) (%3%)").arg(p.filesDone).arg(p.filesTotal).arg(percentDone(p));
+        QMetaObject::invokeMethod(this, [this, message]() { statusBar()->showMessage(message); });
+    }, [this](const SyncResult &result) {
+        const QStringList failures = firstLines(result.failures);
+        const bool cancelled = result.cancelled;
+        const QLocale locale;
+        const QString written = locale.formattedDataSize(result.bytesWritten);
+        const QString matched = locale.formattedDataSize(result.bytesMatched);
+        QMetaObject::invokeMethod(this, [this, failures, cancelled, written, matched]() {
+            if (cancelled) {
+                statusBar()->showMessage("Sync cancelled");
+            } else if (!failures.isEmpty()) {
+                statusBar()->clearMessage();
+                QMessageBox::warning(this, "Error", "Sync finished with errors.\n\n" + failures.join("\n"));
+            } else {
+                statusBar()->showMessage(QString("Sync finished, %1 written, %2 already identical").arg(written, matched), 5000);
+            }
+        });
+    });
 }
 
 void MainWindow::showContextMenu(const QPoint &pos) {
@@ -484,59 +750,72 @@ void MainWindow::showContextMenu(const QPoint &pos) {
     // OR we can simple text. Most "Dark" themes rely on text.
     // However, I will use ic_file.png for file ops just to show "custom" nature.
     
-    menu.addAction(QIcon(getAssetPath("ic_file.png")), "Rename", this, &MainWindow::renameSelected);
-    menu.addAction(QIcon(getAssetPath("ic_file.png")), "Copy", this, &MainWindow::copySelected);
-    menu.addAction(QIcon(getAssetPath("ic_file.png")), "Cut", this, &MainWindow::cutSelected);
-    menu.addAction(QIcon(getAssetPath("ic_file.png")), "Paste", this, &MainWindow::pasteToCurrent);
-    menu.addAction(QIcon(getAssetPath("ic_file.png")), "Delete", this, &MainWindow::deleteSelected);
+    menu.addAction(assetIcon("ic_file.png"), "Rename", this, &MainWindow::renameSelected);
+    menu.addAction(assetIcon("ic_file.png"), "Copy", this, &MainWindow::copySelected);
+    menu.addAction(assetIcon("ic_file.png"), "Cut", this, &MainWindow::cutSelected);
+    menu.addAction(assetIcon("ic_file.png"), "Paste", this, &MainWindow::pasteToCurrent);
+    menu.addAction(assetIcon("ic_file.png"), "Delete", this, &MainWindow::deleteSelected);
+    menu.addSeparator();
+    menu.addAction(assetIcon("ic_folder.png"), "New Folder", this, &MainWindow::createNewFolder);
+    menu.addAction(assetIcon("ic_file.png"), "New File", this, &MainWindow::createNewFile);
     menu.addSeparator();
-    menu.addAction(QIcon(getAssetPath("ic_folder.png")), "New Folder", this, &MainWindow::createNewFolder);
-    menu.addAction(QIcon(getAssetPath("ic_file.png")), "New File", this, &MainWindow::createNewFile);
+    menu.addAction(assetIcon("ic_folder.png"), "Verify Checksums", this, &MainWindow::verifyChecksums);
+    menu.addAction(assetIcon("ic_folder.png"), "Add New Files to Checksums", this, &MainWindow::addChecksums);
+    menu.addAction(assetIcon("ic_folder.png"), "Sync To...", this, &MainWindow::syncTo);
     menu.exec(m_treeView->viewport()->mapToGlobal(pos));
 }
 
 void MainWindow::toggleHiddenFiles() {
-    if (m_model->filter() & QDir::Hidden) {
-        m_model->setFilter(m_model->filter() & ~QDir::Hidden);
-    } else {
-        m_model->setFilter(m_model->filter() | QDir::Hidden);
-    }
+    m_model->setShowHidden(!m_model->showHidden());
 }
 
 void MainWindow::startGlobalSearch() {
-    QString query = m_searchEdit->text();
-    if (query.isEmpty()) return;
+    QString text = m_searchEdit->text();
+    if (text.trimmed().isEmpty()) return;
+
+    QString error;
+    SearchQuery query = SearchQuery::parse(text, &error);
+    if (!error.isEmpty()) {
+        statusBar()->showMessage(error);
+        return;
+    }
 
-    m_searchList->clear();
+    ensureSearchList();
+    const auto maxHits = QSettings().value("search/maxHits", qulonglong(SearchResultStore::kDefaultMaxHits)).toULongLong();
+    // Rows are ints in the model
+    auto store = std::make_shared<SearchResultStore>(
+        static_cast<std::size_t>(std::clamp<qulonglong>(maxHits, 1, std::numeric_limits<int>::max())));
+    m_searchModel->setStore(store);
     m_stackWidget->setCurrentIndex(1); // Switch to list view
     statusBar()->showMessage("Searching global filesystem... (This may take a while)");
     
-    // Stop any existing search
-    m_engine->stopSearch();
-    
-    // Start new search
-    m_engine->searchAsync(query, [this](const FileInfo &info) {
+    m_engine->setSearchScope(loadSearchScope());
+
+    // Start new search; this supersedes any walk still in flight
+    m_engine->searchAsync(query, store, [this, store](FileSystemEngine::SearchGeneration generation, bool finished) {
         // UI updates must be on main thread
-        QMetaObject::invokeMethod(this, [this, info]() {
-            // Use custom item for sorting
-            SearchResultItem *item = new SearchResultItem(info, m_searchList);
-            // Sorting triggers automatically if sorting is enabled
-            m_searchList->sortItems(Qt::DescendingOrder); 
+        QMetaObject::invokeMethod(this, [this, generation, finished, store]() {
+            // Drop notifications from a superseded search that were already queued
+            if (!m_engine->isCurrentSearch(generation)) return;
+            m_searchModel->refresh(finished);
+            if (finished) {
+                QString message = QString("%1 result(s)").arg(m_searchModel->rowCount());
+                if (store->isTruncated()) message += QString(" (stopped at the limit of %1)").arg(store->maxHits());
+                statusBar()->showMessage(message);
+            }
         });
     });
 }
 
-void MainWindow::onSearchResultClicked(QListWidgetItem *item) {
-    if (!item) return;
-    QString path = item->data(Qt::UserRole).toString();
+void MainWindow::onSearchResultClicked(const QModelIndex &item) {
+    if (!item.isValid()) return;
+    QString path = m_searchModel->filePath(item);
     QFileInfo info(path);
     if (info.isDir()) {
         onDirectoryLoaded(path);
     } else {
+        // The listing is asynchronous; select the file once it arrives
+        m_pendingSelection = path;
         onDirectoryLoaded(info.path());
-        // Ideally select the file too
-        QModelIndex index = m_model->index(path);
-        m_treeView->setCurrentIndex(index);
-        m_treeView->scrollTo(index);
     }
 }
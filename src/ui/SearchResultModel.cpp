@@ -0,0 +1,100 @@
+#include "ui/SearchResultModel.h"
+#include <algorithm>
+#include <numeric>
+
+SearchResultModel::SearchResultModel(QObject *parent) : QAbstractListModel(parent) {}
+
+void SearchResultModel::setIcons(const QIcon &folder, const QIcon &file) {
+    m_folderIcon = folder;
+    m_fileIcon = file;
+}
+
+void SearchResultModel::setStore(std::shared_ptr<const SearchResultStore> store) {
+    beginResetModel();
+    m_store = std::move(store);
+    m_order.clear();
+    m_scores.clear();
+    endResetModel();
+}
+
+bool SearchResultModel::byScore(std::uint32_t a, std::uint32_t b) const {
+    if (m_scores[a] != m_scores[b]) return m_scores[a] > m_scores[b];
+    return a < b;
+}
+
+void SearchResultModel::refresh(bool finished) {
+    if (!m_store) return;
+    const std::size_t seen = m_scores.size();
+    const std::size_t available = m_store->hitCount();
+
+    if (available > seen) {
+        std::vector<std::int32_t> fresh;
+        m_store->scores(seen, available, fresh);
+        m_scores.insert(m_scores.end(), fresh.begin(), fresh.end());
+
+        // Only the new hits are touched while the walk runs: they are ranked
+        // among themselves and appended, so a tick costs O(new hits)
+        std::vector<std::uint32_t> added(fresh.size());
+        std::iota(added.begin(), added.end(), static_cast<std::uint32_t>(seen));
+        std::sort(added.begin(), added.end(), [this](std::uint32_t a, std::uint32_t b) { return byScore(a, b); });
+
+        const int first = static_cast<int>(m_order.size());
+        beginInsertRows(QModelIndex(), first, first + static_cast<int>(added.size()) - 1);
+        m_order.insert(m_order.end(), added.begin(), added.end());
+        endInsertRows();
+    }
+
+    if (finished) rankAll();
+}
+
+void SearchResultModel::rankAll() {
+    if (std::is_sorted(m_order.begin(), m_order.end(), [this](std::uint32_t a, std::uint32_t b) { return byScore(a, b); })) {
+        return;
+    }
+
+    // One global ranking when the walk ends; persistent indexes (selection,
+    // current row) move along with their hits
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+    const QModelIndexList persistent = persistentIndexList();
+    std::vector<std::uint32_t> persistentHits;
+    persistentHits.reserve(persistent.size());
+    for (const QModelIndex &index : persistent) persistentHits.push_back(m_order[index.row()]);
+
+    std::sort(m_order.begin(), m_order.end(), [this](std::uint32_t a, std::uint32_t b) { return byScore(a, b); });
+
+    if (!persistent.isEmpty()) {
+        std::vector<std::uint32_t> rowOfHit(m_scores.size());
+        for (std::size_t row = 0; row < m_order.size(); ++row) rowOfHit[m_order[row]] = static_cast<std::uint32_t>(row);
+        QModelIndexList moved;
+        moved.reserve(persistent.size());
+        for (std::uint32_t hit : persistentHits) moved << index(static_cast<int>(rowOfHit[hit]), 0);
+        changePersistentIndexList(persistent, moved);
+    }
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
+
+QString SearchResultModel::filePath(const QModelIndex &index) const {
+    if (!m_store || !index.isValid() || index.row() >= rowCount()) return QString();
+    return QString::fromStdString(m_store->path(m_order[index.row()]));
+}
+
+int SearchResultModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : static_cast<int>(m_order.size());
+}
+
+QVariant SearchResultModel::data(const QModelIndex &index, int role) const {
+    if (!m_store || !index.isValid() || index.row() >= rowCount()) return QVariant();
+    const std::uint32_t hit = m_order[index.row()];
+
+    switch (role) {
+    case Qt::DisplayRole:
+    case Qt::UserRole:
+        return QString::fromStdString(m_store->path(hit));
+    case Qt::ToolTipRole:
+        return m_store->isDir(hit) ? "Directory" : "File";
+    case Qt::DecorationRole:
+        return m_store->isDir(hit) ? m_folderIcon : m_fileIcon;
+    default:
+        return QVariant();
+    }
+}